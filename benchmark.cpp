@@ -0,0 +1,92 @@
+#define CATCH_CONFIG_RUNNER
+#include <catch2/catch.hpp>
+
+#include <iomanip>
+#include <string>
+#include <vector>
+
+// benchmark results of the run as one json document, timings in nanoseconds
+struct JsonReporter : Catch::StreamingReporterBase<JsonReporter> {
+  using StreamingReporterBase::StreamingReporterBase;
+
+  static std::string getDescription() { return "Reports benchmark timings as json"; }
+
+  void assertionStarting(const Catch::AssertionInfo&) override {}
+
+  bool assertionEnded(const Catch::AssertionStats& stats) override {
+    failed += !stats.assertionResult.isOk();
+    return true;
+  }
+
+  void benchmarkEnded(const Catch::BenchmarkStats<>& stats) override {
+    results.push_back({currentTestCaseInfo->name, stats.info.name, stats.info.samples,
+                       stats.info.iterations, stats.mean.point.count(),
+                       stats.mean.lower_bound.count(), stats.mean.upper_bound.count(),
+                       stats.standardDeviation.point.count()});
+  }
+
+  void benchmarkFailed(const std::string& error) override {
+    failed++;
+    errors.push_back(error);
+  }
+
+  void testRunEnded(const Catch::TestRunStats& stats) override {
+    stream << std::setprecision(9) << "{\n  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results.size(); i++) {
+      const auto& r = results[i];
+      stream << (i == 0 ? "\n" : ",\n") << "    {\"test_case\": " << quoted(r.test_case)
+             << ", \"name\": " << quoted(r.name) << ", \"samples\": " << r.samples
+             << ", \"iterations\": " << r.iterations << ", \"mean_ns\": " << r.mean
+             << ", \"mean_lower_ns\": " << r.mean_lower << ", \"mean_upper_ns\": " << r.mean_upper
+             << ", \"std_dev_ns\": " << r.std_dev << "}";
+    }
+    stream << "\n  ],\n  \"errors\": [";
+    for (std::size_t i = 0; i < errors.size(); i++) {
+      stream << (i == 0 ? "" : ", ") << quoted(errors[i]);
+    }
+    stream << "],\n  \"failed_assertions\": " << failed << "\n}\n";
+    StreamingReporterBase::testRunEnded(stats);
+  }
+
+  static std::string quoted(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+      if (c == '"' || c == '\\') {
+        out += '\\';
+      }
+      out += (c == '\n' || c == '\t') ? ' ' : c;
+    }
+    return out + '"';
+  }
+
+  struct Result {
+    std::string test_case;
+    std::string name;
+    int samples;
+    int iterations;
+    double mean;
+    double mean_lower;
+    double mean_upper;
+    double std_dev;
+  };
+  std::vector<Result> results;
+  std::vector<std::string> errors;
+  int failed{0};
+};
+
+CATCH_REGISTER_REPORTER("json", JsonReporter)
+
+// runs the dataset benchmarks with the json reporter unless told otherwise
+int main(int argc, char* argv[]) {
+  Catch::Session session;
+  session.configData().reporterName = "json";
+
+  int result = session.applyCommandLine(argc, argv);
+  if (result != 0) {
+    return result;
+  }
+  if (session.configData().testsOrTags.empty()) {
+    session.configData().testsOrTags.push_back("[dataset]");
+  }
+  return session.run();
+}
@@ -6,9 +6,7 @@
 #include <sstream>
 #include <vector>
 
-std::vector<int> read_inputs(std::string file) {
-  std::ifstream in(file, std::ifstream::in);
-
+std::vector<int> read_inputs(std::istream& in) {
   std::vector<int> ret;
 
   while (in.good()) {
@@ -19,6 +17,11 @@ std::vector<int> read_inputs(std::string file) {
   return ret;
 }
 
+std::vector<int> read_inputs(std::string file) {
+  std::ifstream in(file, std::ifstream::in);
+  return read_inputs(in);
+}
+
 std::pair<int, int> find_first_sum(const std::vector<int> values, int sum) {
   for (int i = 0; i < values.size(); i++) {
     for (int j = i + 1; j < values.size(); j++) {
@@ -64,3 +67,17 @@ TEST_CASE("day 1") {
     std::cout << " day 1 part 2 : " << n1 * n2 * n3 << "\n";
   }
 }
+
+TEST_CASE("day 1 benchmark", "[.][benchmark][dataset]") {
+  std::string input_file_01{DATA_DIR "/dataset/input_01.txt"};
+  std::ifstream in(input_file_01, std::ifstream::in);
+  const std::string text(std::istreambuf_iterator<char>(in), {});
+  auto vect = read_inputs(input_file_01);
+
+  BENCHMARK("day 1 parse") {
+    std::istringstream input(text);
+    return read_inputs(input);
+  };
+  BENCHMARK("day 1 part 1") { return find_first_sum(vect, 2020); };
+  BENCHMARK("day 1 part 2") { return find_first_sum_of_3(vect, 2020); };
+}
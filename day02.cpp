@@ -93,3 +93,17 @@ TEST_CASE("day 2  ") {
   std::cout << " day 2 part 1 : " << count_valid_password(table, is_valid) << "\n";
   std::cout << " day 2 part 2 : " << count_valid_password(table, is_valid_new_policy) << "\n";
 }
+
+TEST_CASE("day 2 benchmark", "[.][benchmark][dataset]") {
+  std::ifstream in(DATA_DIR "/dataset/input_02.txt", std::ifstream::in);
+  const std::string text(std::istreambuf_iterator<char>(in), {});
+  std::istringstream parsed(text);
+  auto table = read_password_table(parsed);
+
+  BENCHMARK("day 2 parse") {
+    std::istringstream input(text);
+    return read_password_table(input);
+  };
+  BENCHMARK("day 2 part 1") { return count_valid_password(table, is_valid); };
+  BENCHMARK("day 2 part 2") { return count_valid_password(table, is_valid_new_policy); };
+}
@@ -73,4 +73,18 @@ TEST_CASE("day 3  ") {
 
   std::cout << " day 3 part 1 : " << count_trees_with_slope(3, 1, forest) << "\n";
   std::cout << " day 3 part 2 : " << count_and_multiply_slopes(forest) << "\n";
-}
\ No newline at end of file
+}
+
+TEST_CASE("day 3 benchmark", "[.][benchmark][dataset]") {
+  std::ifstream in(DATA_DIR "/dataset/input_03.txt", std::ifstream::in);
+  const std::string text(std::istreambuf_iterator<char>(in), {});
+  std::istringstream parsed(text);
+  auto forest = read_forest(parsed);
+
+  BENCHMARK("day 3 parse") {
+    std::istringstream input(text);
+    return read_forest(input);
+  };
+  BENCHMARK("day 3 part 1") { return count_trees_with_slope(3, 1, forest); };
+  BENCHMARK("day 3 part 2") { return count_and_multiply_slopes(forest); };
+}
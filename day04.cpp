@@ -288,4 +288,18 @@ TEST_CASE("day 4  ") {
 
   std::cout << " day 4 part 1 : " << count_required_fields_passports(batch) << "\n";
   std::cout << " day 4 part 2 : " << count_valid_passports(batch) << "\n";
-}
\ No newline at end of file
+}
+
+TEST_CASE("day 4 benchmark", "[.][benchmark][dataset]") {
+  std::ifstream in(DATA_DIR "/dataset/input_04.txt", std::ifstream::in);
+  const std::string text(std::istreambuf_iterator<char>(in), {});
+  std::istringstream parsed(text);
+  auto batch = read_batch(parsed);
+
+  BENCHMARK("day 4 parse") {
+    std::istringstream input(text);
+    return read_batch(input);
+  };
+  BENCHMARK("day 4 part 1") { return count_required_fields_passports(batch); };
+  BENCHMARK("day 4 part 2") { return count_valid_passports(batch); };
+}
@@ -236,4 +236,24 @@ TEST_CASE("day 5  ") {
 
   std::cout << " day 5 part 1 : " << highest_seat_id(bbp) << "\n";
   std::cout << " day 5 part 2 : " << p.find_first_free_seat_with_neigbors().id << "\n";
-}
\ No newline at end of file
+}
+
+TEST_CASE("day 5 benchmark", "[.][benchmark][dataset]") {
+  std::ifstream in(DATA_DIR "/dataset/input_05.txt", std::ifstream::in);
+  const std::string text(std::istreambuf_iterator<char>(in), {});
+  std::istringstream parsed(text);
+  auto bbp = read_binary_boarding_passes(parsed);
+
+  BENCHMARK("day 5 parse") {
+    std::istringstream input(text);
+    return read_binary_boarding_passes(input);
+  };
+  BENCHMARK("day 5 part 1") { return highest_seat_id(bbp); };
+  BENCHMARK("day 5 part 2") {
+    Plane p(128, 8);
+    for (const auto& pass : to_boarding_passes(bbp)) {
+      p.take(pass);
+    }
+    return p.find_first_free_seat_with_neigbors().id;
+  };
+}
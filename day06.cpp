@@ -62,6 +62,45 @@ int count_sum_of_unanimous_yes_of_groups(std::istream& in) {
   return ranges::accumulate(numbers_of_unanimous_yes_by_group, 0);
 }
 
+using Groups = std::vector<std::vector<std::string>>;
+
+// answers of every group, the groups are separated by blank lines
+Groups read_groups(std::istream& in) {
+  Groups groups(1);
+  for (std::string line; std::getline(in, line);) {
+    if (!line.empty()) {
+      groups.back().push_back(line);
+    } else if (!groups.back().empty()) {
+      groups.emplace_back();
+    }
+  }
+  if (groups.back().empty()) {
+    groups.pop_back();
+  }
+  return groups;
+}
+
+// same counts on groups already parsed
+int count_sum_of_yes_of_groups(const Groups& groups) {
+  int sum = 0;
+  for (const auto& group : groups) {
+    std::set<char> yes;
+    for (const auto& answers : group) {
+      yes.insert(answers.begin(), answers.end());
+    }
+    sum += yes.size();
+  }
+  return sum;
+}
+
+int count_sum_of_unanimous_yes_of_groups(const Groups& groups) {
+  int sum = 0;
+  for (const auto& group : groups) {
+    sum += unanimous_answers_from_group(group).size();
+  }
+  return sum;
+}
+
 TEST_CASE("Custom Customs example") {
   std::string data(R"_(abc
 
@@ -81,6 +120,13 @@ b)_");
   std::istringstream in1{data}, in2(data);
   REQUIRE(count_sum_of_yes_of_groups(in1) == 11);
   REQUIRE(count_sum_of_unanimous_yes_of_groups(in2) == 6);
+
+  std::istringstream in3{data};
+  auto groups = read_groups(in3);
+  REQUIRE(groups.size() == 5);
+  REQUIRE(groups[1] == std::vector<std::string>{"a", "b", "c"});
+  REQUIRE(count_sum_of_yes_of_groups(groups) == 11);
+  REQUIRE(count_sum_of_unanimous_yes_of_groups(groups) == 6);
 }
 
 TEST_CASE("day 6  ") {
@@ -88,6 +134,29 @@ TEST_CASE("day 6  ") {
   std::ifstream in2(DATA_DIR "/dataset/input_06.txt", std::ifstream::in);
   REQUIRE(in.good());
 
-  std::cout << " day 6 part 1 : " << count_sum_of_yes_of_groups(in) << "\n";
-  std::cout << " day 6 part 2 : " << count_sum_of_unanimous_yes_of_groups(in2) << "\n";
-}
\ No newline at end of file
+  std::ifstream in3(DATA_DIR "/dataset/input_06.txt", std::ifstream::in);
+  const auto groups = read_groups(in3);
+
+  const auto part1 = count_sum_of_yes_of_groups(groups);
+  const auto part2 = count_sum_of_unanimous_yes_of_groups(groups);
+  REQUIRE(count_sum_of_yes_of_groups(in) == part1);
+  REQUIRE(count_sum_of_unanimous_yes_of_groups(in2) == part2);
+
+  std::cout << " day 6 part 1 : " << part1 << "\n";
+  std::cout << " day 6 part 2 : " << part2 << "\n";
+}
+
+TEST_CASE("day 6 benchmark", "[.][benchmark][dataset]") {
+  std::ifstream in(DATA_DIR "/dataset/input_06.txt", std::ifstream::in);
+  const std::string text(std::istreambuf_iterator<char>(in), {});
+
+  std::istringstream parsed(text);
+  const auto groups = read_groups(parsed);
+
+  BENCHMARK("day 6 parse") {
+    std::istringstream input(text);
+    return read_groups(input);
+  };
+  BENCHMARK("day 6 part 1") { return count_sum_of_yes_of_groups(groups); };
+  BENCHMARK("day 6 part 2") { return count_sum_of_unanimous_yes_of_groups(groups); };
+}
@@ -186,4 +186,18 @@ TEST_CASE("day 7  ") {
 
   std::cout << " day 7 part 1 : " << count_potential_containing("shiny gold", dico) << "\n";
   std::cout << " day 7 part 2 : " << count_bags(dico.bag("shiny gold"), dico) << "\n";
-}
\ No newline at end of file
+}
+
+TEST_CASE("day 7 benchmark", "[.][benchmark][dataset]") {
+  std::ifstream in(DATA_DIR "/dataset/input_07.txt", std::ifstream::in);
+  const std::string text(std::istreambuf_iterator<char>(in), {});
+  std::istringstream parsed(text);
+  auto dico = parse_bags(parsed);
+
+  BENCHMARK("day 7 parse") {
+    std::istringstream input(text);
+    return parse_bags(input);
+  };
+  BENCHMARK("day 7 part 1") { return count_potential_containing("shiny gold", dico); };
+  BENCHMARK("day 7 part 2") { return count_bags(dico.bag("shiny gold"), dico); };
+}
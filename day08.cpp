@@ -36,14 +36,79 @@ int acc_offset(const Command& cmd) {
   return 0;
 }
 
-struct Cpu {
-  explicit Cpu(const Program& pr) : program(pr) {}
+std::string to_string(const Command& cmd) {
+  if (std::holds_alternative<Nop>(cmd)) {
+    return "nop " + std::to_string(std::get<Nop>(cmd).value);
+  }
+  if (std::holds_alternative<Acc>(cmd)) {
+    return "acc " + std::to_string(std::get<Acc>(cmd).value);
+  }
+  return "jmp " + std::to_string(std::get<Jmp>(cmd).offset);
+}
+
+// profiling policies of the Cpu: the default one compiles to nothing
+struct NoProfiling {
+  void reset(std::size_t /*program_size*/) {}
+  void on_execute(int /*line*/, const Command& /*cmd*/, int /*next*/) {}
+};
+
+struct ExecutionProfile {
+  void reset(std::size_t program_size) {
+    hits.assign(program_size, 0);
+    jump_targets.clear();
+    steps = 0;
+  }
+
+  void on_execute(int line, const Command& cmd, int next) {
+    hits[line]++;
+    steps++;
+    if (std::holds_alternative<Jmp>(cmd)) {
+      jump_targets[next]++;
+    }
+  }
+
+  unsigned long long jumps_to(int line) const {
+    auto it = jump_targets.find(line);
+    return it == jump_targets.end() ? 0 : it->second;
+  }
+
+  void to_csv(std::ostream& out, const Program& program) const {
+    out << "line,instruction,hits,jumps_to\n";
+    for (std::size_t line = 0; line < hits.size(); line++) {
+      out << line << ',' << to_string(program.at(line)) << ',' << hits[line] << ','
+          << jumps_to((int)line) << '\n';
+    }
+  }
+
+  void to_json(std::ostream& out) const {
+    out << "{\"steps\":" << steps << ",\"hits\":[";
+    for (std::size_t line = 0; line < hits.size(); line++) {
+      out << (line ? "," : "") << hits[line];
+    }
+    out << "],\"jump_targets\":{";
+    bool first = true;
+    for (auto [target, count] : jump_targets) {
+      out << (first ? "" : ",") << '"' << target << "\":" << count;
+      first = false;
+    }
+    out << "}}";
+  }
+
+  std::vector<unsigned long long> hits;            // per line
+  std::map<int, unsigned long long> jump_targets;  // jmp destination histogram
+  unsigned long long steps{0};
+};
+
+template <typename Profiler = NoProfiling>
+struct BasicCpu {
+  explicit BasicCpu(const Program& pr) : program(pr) {}
 
   bool finished() const { return pointer == program.size(); }
 
   void execute() {
     pointer = 0;
     acc = 0;
+    profiler.reset(program.size());
 
     while (1) {
       // fin de program
@@ -58,7 +123,9 @@ struct Cpu {
       }
       acc += acc_offset(cmd);
 
-      pointer += command_offset(cmd);
+      int next = pointer + command_offset(cmd);
+      profiler.on_execute(pointer, cmd, next);
+      pointer = next;
     }
   }
 
@@ -71,7 +138,7 @@ struct Cpu {
     return ranges::distance(std::begin(program), it);
   }
 
-  Cpu mutate(int& mutated_pointer) {
+  BasicCpu mutate(int& mutated_pointer) {
     Program prg = program;
 
     mutated_pointer = next_command_to_mutate(mutated_pointer);
@@ -89,15 +156,19 @@ struct Cpu {
       cmd.swap(m);
     }
 
-    return Cpu{prg};
+    return BasicCpu{prg};
   }
 
   Program program;
   int pointer{0};
   int acc{0};
   std::set<int> executed_lines;
+  Profiler profiler;
 };
 
+using Cpu = BasicCpu<>;
+using ProfiledCpu = BasicCpu<ExecutionProfile>;
+
 Program fix_program(const Program& program) {
   int ptr = 0;
 
@@ -113,6 +184,104 @@ Program fix_program(const Program& program) {
   return mutate.program;
 }
 
+// without conditional branch, each line has exactly one successor: the control flow is a
+// functional graph that can be analysed once instead of running the program
+struct ControlFlow {
+  enum Fate { Unknown, Terminates, Loops, OutOfBounds };
+
+  explicit ControlFlow(const Program& program) : size((int)program.size()) {
+    successor.reserve(size);
+    acc_values.reserve(size);
+    for (int line = 0; line < size; line++) {
+      const Command& cmd = program[line];
+      long target = (long)line + command_offset(cmd);
+      successor.push_back((target < 0 || target > size) ? out_of_bounds() : (int)target);
+      acc_values.push_back(acc_offset(cmd));
+    }
+    resolve_fates();
+    walk_from_start();
+  }
+
+  int end() const { return size; }
+  int out_of_bounds() const { return size + 1; }
+
+  bool is_reachable(int line) const { return reachable.at(line); }
+  Fate fate(int line) const { return fates.at(line); }
+
+  bool finishes() const { return fates.at(0) == Terminates; }
+
+  // part 2: flip a single jmp/nop on the executed path so that the program reaches the end
+  long long repaired_acc(const Program& program) const {
+    long long acc_before = 0;
+    for (int line : path) {
+      const Command& cmd = program[line];
+      if (!std::holds_alternative<Acc>(cmd)) {
+        int flipped_offset = std::holds_alternative<Jmp>(cmd) ? 1 : std::get<Nop>(cmd).value;
+        long target = (long)line + flipped_offset;
+        if (target >= 0 && target <= size && fates[target] == Terminates) {
+          return acc_before + acc_to_end[target];
+        }
+      }
+      acc_before += acc_values[line];
+    }
+    throw std::runtime_error("cannot repair program");
+  }
+
+  int size;
+  std::vector<int> successor;  // end() or out_of_bounds() when leaving the program
+  std::vector<int> acc_values;
+
+  std::vector<Fate> fates;            // size + 2 entries, sinks included
+  std::vector<long long> acc_to_end;  // valid when fate is Terminates
+  std::vector<bool> reachable;        // lines executed from line 0
+  std::vector<int> path;              // lines in execution order, each one once
+  int loop_entry{-1};                 // first line executed twice, -1 when no loop
+  long long acc{0};                   // part 1: accumulator when execution stops
+
+ private:
+  // path compression: every walk stops on a resolved line and resolves all the visited ones
+  void resolve_fates() {
+    fates.assign(size + 2, Unknown);
+    acc_to_end.assign(size + 2, 0);
+    fates[end()] = Terminates;
+    fates[out_of_bounds()] = OutOfBounds;
+
+    std::vector<bool> on_stack(size, false);
+    std::vector<int> stack;
+    for (int start = 0; start < size; start++) {
+      int line = start;
+      while (fates[line] == Unknown && !on_stack[line]) {
+        on_stack[line] = true;
+        stack.push_back(line);
+        line = successor[line];
+      }
+      Fate fate = (fates[line] == Unknown) ? Loops : fates[line];
+      long long acc_next = acc_to_end[line];
+      for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
+        fates[*it] = fate;
+        acc_next += acc_values[*it];
+        acc_to_end[*it] = (fate == Terminates) ? acc_next : 0;
+        on_stack[*it] = false;
+      }
+      stack.clear();
+    }
+  }
+
+  void walk_from_start() {
+    reachable.assign(size, false);
+    int line = 0;
+    while (line < size && !reachable[line]) {
+      reachable[line] = true;
+      path.push_back(line);
+      acc += acc_values[line];
+      line = successor[line];
+    }
+    if (line < size) {
+      loop_entry = line;
+    }
+  }
+};
+
 Program parse_commands(std::istream& in) {
   Program prog;
   while (in.good()) {
@@ -186,6 +355,54 @@ acc +6)_");
     fixed_cpu.execute();
     REQUIRE(fixed_cpu.acc == 8);
   }
+
+  SECTION("profiling") {
+    ProfiledCpu cpu(prog);
+    cpu.execute();
+    REQUIRE(cpu.acc == 5);
+
+    const auto& profile = cpu.profiler;
+    REQUIRE(profile.steps == 7);
+    REQUIRE(profile.hits == std::vector<unsigned long long>{1, 1, 1, 1, 1, 0, 1, 1, 0});
+    REQUIRE(profile.jumps_to(6) == 1);
+    REQUIRE(profile.jumps_to(5) == 0);
+
+    std::ostringstream json;
+    profile.to_json(json);
+    REQUIRE(json.str() ==
+            R"({"steps":7,"hits":[1,1,1,1,1,0,1,1,0],"jump_targets":{"1":1,"3":1,"6":1}})");
+
+    std::ostringstream csv;
+    profile.to_csv(csv, prog);
+    std::istringstream lines(csv.str());
+    std::string header, first_line, third_line;
+    std::getline(lines, header);
+    std::getline(lines, first_line);
+    std::getline(lines, third_line);
+    std::getline(lines, third_line);
+    REQUIRE(header == "line,instruction,hits,jumps_to");
+    REQUIRE(first_line == "0,nop 0,1,0");
+    REQUIRE(third_line == "2,jmp 4,1,0");
+  }
+
+  SECTION("static control flow") {
+    ControlFlow flow(prog);
+
+    REQUIRE(flow.finishes() == false);
+    REQUIRE(flow.loop_entry == 1);
+    REQUIRE(flow.acc == 5);
+
+    REQUIRE(flow.path == std::vector<int>{0, 1, 2, 6, 7, 3, 4});
+    REQUIRE(flow.is_reachable(6));
+    REQUIRE_FALSE(flow.is_reachable(5));
+    REQUIRE_FALSE(flow.is_reachable(8));
+
+    REQUIRE(flow.fate(0) == ControlFlow::Loops);
+    REQUIRE(flow.fate(8) == ControlFlow::Terminates);
+    REQUIRE(flow.fate(5) == ControlFlow::Loops);
+
+    REQUIRE(flow.repaired_acc(prog) == 8);
+  }
 };
 
 TEST_CASE("day 8  ") {
@@ -203,4 +420,31 @@ TEST_CASE("day 8  ") {
   fixed_cpu.execute();
 
   std::cout << " day 8 part 2 : " << fixed_cpu.acc << "\n";
-}
\ No newline at end of file
+
+  ControlFlow flow(prog);
+  REQUIRE(flow.acc == cpu.acc);
+  REQUIRE(flow.repaired_acc(prog) == fixed_cpu.acc);
+}
+
+TEST_CASE("day 8 benchmark", "[.][benchmark][dataset]") {
+  std::ifstream in(DATA_DIR "/dataset/input_08.txt", std::ifstream::in);
+  const std::string text(std::istreambuf_iterator<char>(in), {});
+  std::istringstream parsed(text);
+  auto prog = parse_commands(parsed);
+
+  BENCHMARK("day 8 parse") {
+    std::istringstream input(text);
+    return parse_commands(input);
+  };
+  BENCHMARK("day 8 part 1") {
+    Cpu cpu(prog);
+    cpu.execute();
+    return cpu.acc;
+  };
+  BENCHMARK("day 8 part 2") {
+    Cpu fixed_cpu(fix_program(prog));
+    fixed_cpu.execute();
+    return fixed_cpu.acc;
+  };
+  BENCHMARK("day 8 part 2 control flow") { return ControlFlow(prog).repaired_acc(prog); };
+}
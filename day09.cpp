@@ -3,6 +3,7 @@
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <optional>
 #include <range/v3/all.hpp>  // get everything
 #include <set>
 #include <sstream>
@@ -37,6 +38,76 @@ std::pair<int, unsigned long long> find_first_wrong_number(std::vector<unsigned
   throw std::runtime_error("cannot find wrong number");
 }
 
+// last `len` numbers kept in a ring buffer, with a sorted copy for pair lookups. A push is an
+// O(len) memmove, not the O(1) of a hash multiset. The pair lookup is O(len) with either one, and
+// the sorted copy lets it reject most sums at once and scan contiguous memory
+struct XmasWindow {
+  explicit XmasWindow(std::size_t len) : ring(len) { sorted.reserve(len); }
+
+  bool full() const { return filled == ring.size(); }
+
+  // the sorted copy shifts the numbers between the leaving and the entering one
+  void push(unsigned long long value) {
+    if (full()) {
+      auto out = std::lower_bound(sorted.begin(), sorted.end(), ring[head]);
+      auto in = std::upper_bound(sorted.begin(), sorted.end(), value);
+      if (in > out) {
+        std::move(out + 1, in, out);
+        *(in - 1) = value;
+      } else {
+        std::move_backward(in, out, out + 1);
+        *in = value;
+      }
+    } else {
+      filled++;
+      sorted.insert(std::upper_bound(sorted.begin(), sorted.end(), value), value);
+    }
+    ring[head] = value;
+    head = head + 1 == ring.size() ? 0 : head + 1;
+  }
+
+  // two different numbers of the window sum to value: two pointers over the sorted window
+  bool is_sum_of_pair(unsigned long long value) const {
+    if (filled < 2 || value < sorted[0] + sorted[1] ||
+        value > sorted[filled - 1] + sorted[filled - 2]) {
+      return false;
+    }
+    std::size_t lo = 0, hi = filled - 1;
+    while (lo < hi) {
+      auto sum = sorted[lo] + sorted[hi];
+      if (sum == value) {
+        // equal ends mean every number in between is equal too
+        return sorted[lo] != sorted[hi];
+      }
+      if (sum < value) {
+        lo++;
+      } else {
+        hi--;
+      }
+    }
+    return false;
+  }
+
+  std::vector<unsigned long long> ring;
+  std::size_t head{0};
+  std::size_t filled{0};
+  std::vector<unsigned long long> sorted;
+};
+
+std::pair<int, unsigned long long> find_first_wrong_number_windowed(
+    const std::vector<unsigned long long>& numbers,
+    int len) {
+  XmasWindow window(len);
+  for (int i = 0; i < (int)numbers.size(); i++) {
+    auto value = numbers[i];
+    if (window.full() && !window.is_sum_of_pair(value)) {
+      return {i, value};
+    }
+    window.push(value);
+  }
+  throw std::runtime_error("cannot find wrong number");
+}
+
 std::pair<int, int> find_contigous(std::vector<unsigned long long> numbers,
                                    unsigned long long val) {
   for (int i : ranges::views::ints(0, static_cast<int>(numbers.size()))) {
@@ -53,6 +124,179 @@ std::pair<int, int> find_contigous(std::vector<unsigned long long> numbers,
   throw std::runtime_error("cannot find wrong number");
 }
 
+// sums[i] is the sum of the first i numbers: any contiguous range sum is one subtraction
+struct PrefixSums {
+  explicit PrefixSums(const std::vector<unsigned long long>& numbers)
+      : sums(numbers.size() + 1, 0) {
+    for (std::size_t i = 0; i < numbers.size(); i++) {
+      sums[i + 1] = sums[i] + numbers[i];
+    }
+  }
+
+  int size() const { return (int)sums.size() - 1; }
+
+  // sum of numbers[first..last]
+  unsigned long long sum(int first, int last) const { return sums[last + 1] - sums[first]; }
+
+  // two pointers over unsigned values: first range of at least two numbers summing to target
+  std::optional<std::pair<int, int>> find_range(unsigned long long target) const {
+    int lo = 0;
+    int hi = 2;  // exclusive
+    while (hi <= size()) {
+      auto s = sums[hi] - sums[lo];
+      if (s == target) {
+        return std::pair{lo, hi - 1};
+      }
+      if (s < target) {
+        hi++;
+      } else {
+        lo++;
+        hi = std::max(hi, lo + 2);
+      }
+    }
+    return std::nullopt;
+  }
+
+  std::vector<unsigned long long> sums;
+};
+
+// O(1) min/max of any range after an O(n log n) precomputation
+struct SparseMinMax {
+  explicit SparseMinMax(const std::vector<unsigned long long>& numbers)
+      : mins{numbers}, maxs{numbers} {
+    const std::size_t n = numbers.size();
+    for (std::size_t width = 2; width <= n; width *= 2) {
+      const auto& min_prev = mins.back();
+      const auto& max_prev = maxs.back();
+      std::vector<unsigned long long> min_level(n - width + 1);
+      std::vector<unsigned long long> max_level(n - width + 1);
+      for (std::size_t i = 0; i + width <= n; i++) {
+        min_level[i] = std::min(min_prev[i], min_prev[i + width / 2]);
+        max_level[i] = std::max(max_prev[i], max_prev[i + width / 2]);
+      }
+      mins.push_back(std::move(min_level));
+      maxs.push_back(std::move(max_level));
+    }
+    // floor(log2(width)) for every range width, so a query has no loop
+    levels.assign(n + 1, 0);
+    for (std::size_t width = 2; width <= n; width++) {
+      levels[width] = levels[width / 2] + 1;
+    }
+  }
+
+  // min and max of numbers[first..last]
+  std::pair<unsigned long long, unsigned long long> minmax(int first, int last) const {
+    const int level = levels[last - first + 1];
+    int second = last + 1 - (1 << level);
+    return {std::min(mins[level][first], mins[level][second]),
+            std::max(maxs[level][first], maxs[level][second])};
+  }
+
+  std::vector<std::vector<unsigned long long>> mins;
+  std::vector<std::vector<unsigned long long>> maxs;
+  std::vector<int> levels;
+};
+
+unsigned long long encryption_weakness(const PrefixSums& prefix,
+                                       const SparseMinMax& table,
+                                       unsigned long long target) {
+  auto range = prefix.find_range(target);
+  if (!range) {
+    throw std::runtime_error("cannot find contiguous range");
+  }
+  auto [min, max] = table.minmax(range->first, range->second);
+  return min + max;
+}
+
+// push based day 9 on an unbounded feed: every number is checked against the preamble window
+// as it arrives, and the contiguous range of an invalid number is searched in a bounded history
+struct XmasInvalid {
+  unsigned long long index;
+  unsigned long long value;
+  std::optional<unsigned long long> weakness;  // min + max of a range in the history
+};
+
+// the history is a linear buffer of twice its length with running prefix sums: once the buffer is
+// full the last numbers move back to its start, so a range sum is one subtraction and the search
+// never wraps
+template <typename OnInvalid>
+struct XmasStream {
+  using Invalid = XmasInvalid;
+
+  XmasStream(std::size_t preamble, std::size_t history_len, OnInvalid on_invalid)
+      : window(preamble),
+        history_len(std::max(history_len, preamble)),
+        values(2 * this->history_len),
+        sums(2 * this->history_len + 1, 0),
+        on_invalid(std::move(on_invalid)) {}
+
+  // false when value is not the sum of two numbers of the preamble window
+  bool push(unsigned long long value) {
+    bool valid = !window.full() || window.is_sum_of_pair(value);
+    if (!valid) {
+      invalid_count++;
+      on_invalid(Invalid{count, value, find_weakness(value)});
+    }
+    window.push(value);
+    push_history(value);
+    count++;
+    return valid;
+  }
+
+  void feed(std::istream& in) {
+    unsigned long long value;
+    while (in >> value) {
+      push(value);
+    }
+  }
+
+  void push_history(unsigned long long value) {
+    if (last == values.size()) {
+      const std::size_t keep = history_len - 1;
+      std::copy(values.begin() + (last - keep), values.begin() + last, values.begin());
+      std::copy(sums.begin() + (last - keep), sums.begin() + last + 1, sums.begin());
+      first = 0;
+      last = keep;
+    }
+    values[last] = value;
+    sums[last + 1] = sums[last] + value;
+    last++;
+    first += (last - first > history_len);
+  }
+
+  // two pointers over the prefix sums, oldest number first
+  std::optional<unsigned long long> find_weakness(unsigned long long target) const {
+    if (last - first < 2 || sums[last] - sums[first] < target) {
+      return std::nullopt;
+    }
+    std::size_t lo = first;
+    std::size_t hi = first + 2;  // exclusive
+    while (hi <= last) {
+      auto sum = sums[hi] - sums[lo];
+      if (sum == target) {
+        auto [min, max] = std::minmax_element(values.begin() + lo, values.begin() + hi);
+        return *min + *max;
+      }
+      if (sum < target || hi - lo == 2) {
+        hi++;
+      } else {
+        lo++;
+      }
+    }
+    return std::nullopt;
+  }
+
+  XmasWindow window;
+  std::size_t history_len;
+  std::vector<unsigned long long> values;
+  std::vector<unsigned long long> sums;  // sums[i + 1] = sums[i] + values[i]
+  std::size_t first{0};
+  std::size_t last{0};
+  OnInvalid on_invalid;
+  unsigned long long count{0};
+  unsigned long long invalid_count{0};
+};
+
 TEST_CASE("Day 9: Encoding Error") {
   std::string data(R"_(35
 20
@@ -87,6 +331,17 @@ TEST_CASE("Day 9: Encoding Error") {
     REQUIRE(check_xmas(numbers | ranges::view::slice(0, 5) | ranges::to_vector, numbers.at(5)));
 
     REQUIRE(find_first_wrong_number(numbers, 5).second == 127);
+    REQUIRE(find_first_wrong_number_windowed(numbers, 5) == std::pair{14, 127ull});
+
+    XmasWindow window(3);
+    for (auto v : {1ull, 2ull, 3ull, 4ull}) {
+      window.push(v);
+    }
+    REQUIRE(window.full());
+    REQUIRE(window.is_sum_of_pair(5));
+    REQUIRE(window.is_sum_of_pair(7));
+    REQUIRE_FALSE(window.is_sum_of_pair(3));  // 1 left the window
+    REQUIRE_FALSE(window.is_sum_of_pair(8));  // 4 + 4 is not a pair
   }
 
   SECTION("part 2") {
@@ -95,6 +350,43 @@ TEST_CASE("Day 9: Encoding Error") {
 
     REQUIRE(min == 2);
     REQUIRE(max == 5);
+
+    PrefixSums prefix(numbers);
+    REQUIRE(prefix.sum(2, 5) == 127);
+    REQUIRE(prefix.find_range(127) == std::pair{2, 5});
+    REQUIRE(prefix.find_range(35 + 20) == std::pair{0, 1});
+    REQUIRE(prefix.find_range(47) == std::nullopt);  // a single number is not a range
+
+    SparseMinMax table(numbers);
+    REQUIRE(table.minmax(2, 5) == std::pair{15ull, 47ull});
+    REQUIRE(table.minmax(7, 7) == std::pair{55ull, 55ull});
+    REQUIRE(table.minmax(0, 19) == std::pair{15ull, 576ull});
+    for (int first = 0; first < 20; first++) {
+      for (int last = first; last < 20; last++) {
+        auto [min, max] = std::minmax_element(numbers.begin() + first, numbers.begin() + last + 1);
+        REQUIRE(table.minmax(first, last) == std::pair{*min, *max});
+      }
+    }
+    REQUIRE(encryption_weakness(prefix, table, 127) == 62);
+  }
+
+  SECTION("stream") {
+    std::vector<XmasInvalid> invalids;
+    XmasStream stream(5, 20, [&invalids](const XmasInvalid& inv) {
+      invalids.push_back(inv);
+    });
+
+    std::istringstream feed{data};
+    stream.feed(feed);
+
+    REQUIRE(stream.count == 20);
+    REQUIRE(stream.invalid_count == invalids.size());
+    REQUIRE(invalids.front().index == 14);
+    REQUIRE(invalids.front().value == 127);
+    REQUIRE(invalids.front().weakness == 62);
+
+    REQUIRE(stream.push(299 + 277) == true);
+    REQUIRE(stream.push(1) == false);
   }
 };
 
@@ -107,6 +399,7 @@ TEST_CASE("day 9  ") {
   auto [index, number] = find_first_wrong_number(numbers, 25);
 
   std::cout << " day 9 part 1 : " << number << "\n";
+  REQUIRE(find_first_wrong_number_windowed(numbers, 25) == std::pair{index, number});
 
   auto [i, j] =
       find_contigous(numbers | ranges::views::slice(0, index) | ranges::to_vector, number);
@@ -114,4 +407,79 @@ TEST_CASE("day 9  ") {
   const auto [min, max] = ranges::minmax_element(numbers | ranges::view::slice(i, j + 1));
 
   std::cout << " day 9 part 2 : " << *min + *max << "\n";
-}
\ No newline at end of file
+
+  REQUIRE(encryption_weakness(PrefixSums(numbers), SparseMinMax(numbers), number) == *min + *max);
+}
+
+TEST_CASE("day 9 benchmark", "[.][benchmark][dataset]") {
+  std::ifstream in(DATA_DIR "/dataset/input_09.txt", std::ifstream::in);
+  const std::string text(std::istreambuf_iterator<char>(in), {});
+  std::istringstream parsed(text);
+  auto numbers = parse_numbers(parsed);
+  // not a structured binding, the benchmarks capture them
+  const auto wrong = find_first_wrong_number(numbers, 25);
+  const auto index = wrong.first;
+  const auto number = wrong.second;
+
+  BENCHMARK("day 9 parse") {
+    std::istringstream input(text);
+    return parse_numbers(input);
+  };
+  BENCHMARK("day 9 part 1") { return find_first_wrong_number(numbers, 25); };
+  BENCHMARK("day 9 part 2") {
+    auto [i, j] =
+        find_contigous(numbers | ranges::views::slice(0, index) | ranges::to_vector, number);
+    const auto [min, max] = ranges::minmax_element(numbers | ranges::view::slice(i, j + 1));
+    return *min + *max;
+  };
+  BENCHMARK("day 9 part 2 prefix sums") {
+    return encryption_weakness(PrefixSums(numbers), SparseMinMax(numbers), number);
+  };
+}
+TEST_CASE("Day 9: stream throughput benchmark", "[.][benchmark]") {
+  std::ifstream in(DATA_DIR "/dataset/input_09.txt", std::ifstream::in);
+  auto numbers = parse_numbers(in);
+
+  // the input replayed: each copy starts with ~25 invalid numbers against the previous copy
+  std::vector<unsigned long long> replay;
+  while (replay.size() < 1000000) {
+    replay.insert(replay.end(), numbers.begin(), numbers.end());
+  }
+  // pseudo random numbers, almost never the sum of a pair
+  std::vector<unsigned long long> noise(100000);
+  uint64_t seed = 42;
+  for (auto& value : noise) {
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    value = seed >> 40;
+  }
+
+  // the weakness is consumed, or the search would be optimised away
+  unsigned long long weakness = 0;
+  BENCHMARK("10^6 replayed input, history 25") {
+    XmasStream stream(25, 25, [&weakness](const XmasInvalid& inv) {
+      weakness += inv.weakness.value_or(0);
+    });
+    for (auto value : replay) {
+      stream.push(value);
+    }
+    return stream.invalid_count + weakness;
+  };
+  BENCHMARK("10^6 replayed input, history 1000") {
+    XmasStream stream(25, 1000, [&weakness](const XmasInvalid& inv) {
+      weakness += inv.weakness.value_or(0);
+    });
+    for (auto value : replay) {
+      stream.push(value);
+    }
+    return stream.invalid_count + weakness;
+  };
+  BENCHMARK("10^5 invalid numbers, history 1000") {
+    XmasStream stream(25, 1000, [&weakness](const XmasInvalid& inv) {
+      weakness += inv.weakness.value_or(0);
+    });
+    for (auto value : noise) {
+      stream.push(value);
+    }
+    return stream.invalid_count + weakness;
+  };
+}
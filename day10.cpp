@@ -79,6 +79,164 @@ unsigned long long count_all_possibilities(std::vector<unsigned long long> numbe
   return ret;
 }
 
+// arbitrary precision unsigned integer, just enough to count arrangements without overflow
+struct BigUnsigned {
+  BigUnsigned(unsigned long long value = 0) {
+    for (; value != 0; value >>= 32) {
+      limbs.push_back(static_cast<uint32_t>(value));
+    }
+  }
+
+  BigUnsigned& operator+=(const BigUnsigned& other) {
+    if (limbs.size() < other.limbs.size()) {
+      limbs.resize(other.limbs.size(), 0);
+    }
+    uint64_t carry = 0;
+    for (std::size_t i = 0; i < limbs.size(); i++) {
+      if (i >= other.limbs.size() && carry == 0)
+        break;
+      uint64_t sum = carry + limbs[i] + (i < other.limbs.size() ? other.limbs[i] : 0);
+      limbs[i] = static_cast<uint32_t>(sum);
+      carry = sum >> 32;
+    }
+    if (carry != 0) {
+      limbs.push_back(static_cast<uint32_t>(carry));
+    }
+    return *this;
+  }
+
+  bool operator==(const BigUnsigned& other) const { return limbs == other.limbs; }
+
+  std::string to_string() const {
+    std::vector<uint32_t> n = limbs;
+    std::string digits;
+    while (!n.empty()) {
+      // divide by 10^9, most significant limb first
+      uint64_t rem = 0;
+      for (auto it = n.rbegin(); it != n.rend(); ++it) {
+        uint64_t cur = (rem << 32) | *it;
+        *it = static_cast<uint32_t>(cur / 1000000000);
+        rem = cur % 1000000000;
+      }
+      while (!n.empty() && n.back() == 0) {
+        n.pop_back();
+      }
+      for (int i = 0; i < 9 && (rem != 0 || !n.empty()); i++) {
+        digits.push_back(static_cast<char>('0' + rem % 10));
+        rem /= 10;
+      }
+    }
+    if (digits.empty()) {
+      digits = "0";
+    }
+    std::reverse(digits.begin(), digits.end());
+    return digits;
+  }
+
+  std::vector<uint32_t> limbs;  // little endian
+};
+
+std::ostream& operator<<(std::ostream& out, const BigUnsigned& n) {
+  return out << n.to_string();
+}
+
+// count modulo Mod, for adapter chains whose arrangement count is too big to be printed anyway
+template <unsigned long long Mod>
+struct Modular {
+  Modular(unsigned long long v = 0) : value(v % Mod) {}
+
+  Modular& operator+=(Modular other) {
+    value += other.value;
+    if (value >= Mod)
+      value -= Mod;
+    return *this;
+  }
+
+  unsigned long long value;
+};
+
+// ways[i] = sum of the ways of the previous adapters within 3 jolts. Jolts are sorted and
+// distinct so only the three previous adapters can be reached: they are kept in a rolling window
+template <typename Count>
+Count count_arrangements(const std::vector<unsigned long long>& sorted_jolts) {
+  const std::size_t n = sorted_jolts.size();
+  if (n == 0)
+    return Count{0};
+
+  std::array<Count, 3> ways{Count{1}, Count{0}, Count{0}};
+  for (std::size_t i = 1; i < n; i++) {
+    Count count{0};
+    for (std::size_t j = (i < 3) ? 0 : i - 3; j < i; j++) {
+      if (sorted_jolts[i] - sorted_jolts[j] <= 3) {
+        count += ways[j % 3];
+      }
+    }
+    ways[i % 3] = std::move(count);
+  }
+  return ways[(n - 1) % 3];
+}
+
+// jolt ratings are small distinct integers: a presence bitmap filled while parsing replaces the
+// sort, and a single scan over it gives both parts
+struct JoltBitmap {
+  JoltBitmap() : present{true} {}  // the outlet
+
+  void set(unsigned long long jolt) {
+    if (jolt >= present.size()) {
+      present.resize(jolt + 1, false);
+    }
+    present[jolt] = true;
+  }
+
+  unsigned long long max() const { return present.size() - 1; }
+
+  std::vector<bool> present;
+};
+
+JoltBitmap parse_adapters_bitmap(std::istream& in) {
+  JoltBitmap bitmap;
+  for (auto jolt : ranges::istream<unsigned long long>(in)) {
+    bitmap.set(jolt);
+  }
+  return bitmap;
+}
+
+template <typename Count>
+struct AdapterScan {
+  int number_of_1{0};
+  int number_of_3{0};
+  Count arrangements;
+};
+
+template <typename Count>
+AdapterScan<Count> scan_adapters(const JoltBitmap& bitmap) {
+  AdapterScan<Count> scan;
+  // ways to reach the jolts v-1, v-2 and v-3, indexed by jolt modulo 4
+  std::array<Count, 4> ways{Count{1}, Count{0}, Count{0}, Count{0}};
+  unsigned long long previous = 0;
+  const unsigned long long max = bitmap.max();
+  for (unsigned long long jolt = 1; jolt <= max; jolt++) {
+    Count count{0};
+    if (bitmap.present[jolt]) {
+      count += ways[(jolt - 1) % 4];
+      count += ways[(jolt - 2) % 4];
+      if (jolt >= 3)
+        count += ways[(jolt - 3) % 4];
+
+      auto dif = jolt - previous;
+      if (dif == 1)
+        scan.number_of_1++;
+      if (dif == 3)
+        scan.number_of_3++;
+      previous = jolt;
+    }
+    ways[jolt % 4] = std::move(count);
+  }
+  scan.number_of_3++;  // the device is always 3 jolts above the last adapter
+  scan.arrangements = std::move(ways[max % 4]);
+  return scan;
+}
+
 TEST_CASE("Day 10: Adapter Array") {
   std::string data(R"_(16
 10
@@ -140,9 +298,59 @@ TEST_CASE("Day 10: Adapter Array") {
     auto numbers2 = parse_adapters_and_sort(in2);
 
     REQUIRE(count_all_possibilities(numbers2) == 19208);
+    REQUIRE(count_arrangements<unsigned long long>(numbers2) == 19208);
+    REQUIRE(count_arrangements<BigUnsigned>(numbers2).to_string() == "19208");
+    REQUIRE(count_arrangements<Modular<1000>>(numbers2).value == 208);
   };
+
+  SECTION("bitmap scan") {
+    std::istringstream in1{data};
+    auto scan = scan_adapters<unsigned long long>(parse_adapters_bitmap(in1));
+    REQUIRE(scan.number_of_1 == 7);
+    REQUIRE(scan.number_of_3 == 5);
+    REQUIRE(scan.arrangements == 8);
+
+    std::istringstream in2{
+        "28 33 18 42 31 14 46 20 48 47 24 23 49 45 19 38 39 "
+        "11 1 32 25 35 8 17 7 9 4 2 34 10 3"};
+    auto scan2 = scan_adapters<BigUnsigned>(parse_adapters_bitmap(in2));
+    REQUIRE(scan2.number_of_1 == 22);
+    REQUIRE(scan2.number_of_3 == 10);
+    REQUIRE(scan2.arrangements.to_string() == "19208");
+  }
+
+  SECTION("general dynamic programming") {
+    REQUIRE(count_arrangements<unsigned long long>(numbers) == 8);
+
+    // long runs and gaps of 2 that count_possibilities does not know
+    auto chain = ranges::views::iota(0ull, 61ull) | ranges::to_vector;
+    chain.push_back(chain.back() + 3);
+    REQUIRE(count_arrangements<unsigned long long>(chain) == 4680045560037375ull);
+    REQUIRE(count_arrangements<BigUnsigned>(chain) == BigUnsigned{4680045560037375ull});
+    REQUIRE(count_arrangements<unsigned long long>({0, 2, 4, 5, 8}) == 2);
+
+    auto long_chain = ranges::views::iota(0ull, 101ull) | ranges::to_vector;
+    long_chain.push_back(long_chain.back() + 3);
+    REQUIRE(count_arrangements<BigUnsigned>(long_chain).to_string() ==
+            "180396380815100901214157639");
+    REQUIRE(count_arrangements<Modular<1000000007>>(long_chain).value == 347873931);
+  }
 };
 
+TEST_CASE("Day 10: arrangement count benchmark", "[.][benchmark]") {
+  // 10^7 adapters with pseudo random gaps of 1, 2 or 3 jolts
+  std::vector<unsigned long long> jolts(10000000);
+  uint64_t seed = 42;
+  for (std::size_t i = 1; i < jolts.size(); i++) {
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    jolts[i] = jolts[i - 1] + 1 + (seed >> 33) % 3;
+  }
+
+  BENCHMARK("modular dp on 10^7 adapters") {
+    return count_arrangements<Modular<1000000007>>(jolts).value;
+  };
+}
+
 TEST_CASE("day 10  ") {
   std::ifstream in(DATA_DIR "/dataset/input_10.txt", std::ifstream::in);
   REQUIRE(in.good());
@@ -153,4 +361,29 @@ TEST_CASE("day 10  ") {
   std::cout << " day 10 part 1 : " << number_of_one * number_of_three << "\n";
 
   std::cout << " day 10 part 2 : " << count_all_possibilities(numbers) << "\n";
-}
\ No newline at end of file
+
+  REQUIRE(count_arrangements<unsigned long long>(numbers) == count_all_possibilities(numbers));
+
+  std::ifstream in_bitmap(DATA_DIR "/dataset/input_10.txt", std::ifstream::in);
+  auto scan = scan_adapters<unsigned long long>(parse_adapters_bitmap(in_bitmap));
+  REQUIRE(scan.number_of_1 == number_of_one);
+  REQUIRE(scan.number_of_3 == number_of_three);
+  REQUIRE(scan.arrangements == count_all_possibilities(numbers));
+}
+
+TEST_CASE("day 10 benchmark", "[.][benchmark][dataset]") {
+  std::ifstream in(DATA_DIR "/dataset/input_10.txt", std::ifstream::in);
+  const std::string text(std::istreambuf_iterator<char>(in), {});
+  std::istringstream parsed(text);
+  auto numbers = parse_adapters_and_sort(parsed);
+
+  BENCHMARK("day 10 parse") {
+    std::istringstream input(text);
+    return parse_adapters_and_sort(input);
+  };
+  BENCHMARK("day 10 part 1") { return diff_and_find_number_of_1_and_3(numbers); };
+  BENCHMARK("day 10 part 2") { return count_all_possibilities(numbers); };
+  BENCHMARK("day 10 part 2 rolling window") {
+    return count_arrangements<unsigned long long>(numbers);
+  };
+}
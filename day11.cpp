@@ -1,12 +1,17 @@
 #include <array>
+#include <bitset>
 #include <catch2/catch.hpp>
+#include <condition_variable>
 #include <fstream>
 #include <iostream>
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <range/v3/all.hpp>  // get everything
 #include <set>
 #include <sstream>
+#include <thread>
 #include <variant>
 #include <vector>
 
@@ -41,6 +46,22 @@ struct Position {
   int row{-1};
 };
 
+enum class Neighbourhood { Adjacent, LineOfSight };
+
+// seating rules resolved at compile time: the neighbours that count, how many occupied ones still
+// let a free seat be taken (birth) and how many make people leave an occupied one (death)
+template <Neighbourhood N, int Birth, int Death>
+struct SeatingRule {
+  static constexpr Neighbourhood neighbourhood = N;
+
+  static constexpr bool occupied_next(bool occupied, int occupied_neighbours) {
+    return occupied ? occupied_neighbours < Death : occupied_neighbours <= Birth;
+  }
+};
+
+using Part1Rule = SeatingRule<Neighbourhood::Adjacent, 0, 4>;
+using Part2Rule = SeatingRule<Neighbourhood::LineOfSight, 0, 5>;
+
 struct GameOfLife {
   GameOfLife(const Room& room_) : room{room_} {}
 
@@ -122,31 +143,27 @@ struct GameOfLife {
   void set_free(Position pos) { room[pos.row][pos.col] = 'L'; }
   void set_occupied(Position pos) { room[pos.row][pos.col] = '#'; }
 
-  GameOfLife next_round() const {
-    GameOfLife next{room};
-    for_each([&next, this](Position pos) {
-      //
-      auto occ = this->count_occupied(pos);
-
-      if (this->is_free_seat(pos) && occ == 0) {
-        next.set_occupied(pos);
-      } else if (this->is_occupied_seat(pos) && occ >= 4) {
-        next.set_free(pos);
-      }
-    });
-
-    return next;
+  template <typename Rule>
+  int occupied_neighbours(Position pos) const {
+    if constexpr (Rule::neighbourhood == Neighbourhood::Adjacent) {
+      return count_occupied(pos);
+    } else {
+      return visible_occupied_seats(pos);
+    }
   }
 
-  GameOfLife next_round_part2() const {
+  template <typename Rule>
+  GameOfLife next_round_with() const {
     GameOfLife next{room};
     for_each([&next, this](Position pos) {
-      //
-      auto occ = this->visible_occupied_seats(pos);
+      if (this->is_floor(pos))
+        return;
+      bool occupied = this->is_occupied_seat(pos);
+      bool occupied_next = Rule::occupied_next(occupied, this->occupied_neighbours<Rule>(pos));
 
-      if (this->is_free_seat(pos) && occ == 0) {
+      if (!occupied && occupied_next) {
         next.set_occupied(pos);
-      } else if (this->is_occupied_seat(pos) && occ >= 5) {
+      } else if (occupied && !occupied_next) {
         next.set_free(pos);
       }
     });
@@ -154,6 +171,10 @@ struct GameOfLife {
     return next;
   }
 
+  GameOfLife next_round() const { return next_round_with<Part1Rule>(); }
+
+  GameOfLife next_round_part2() const { return next_round_with<Part2Rule>(); }
+
   int count_occupied_seats() const {
     int count = 0;
     for_each([&count, this](Position pos) {
@@ -163,12 +184,13 @@ struct GameOfLife {
     return count;
   }
 
-  int converge() const {
+  template <typename Rule>
+  int converge_with() const {
     GameOfLife next(room);
     auto pred = next;
     do {
       pred = next;
-      next = next.next_round();
+      next = next.next_round_with<Rule>();
       // std::cout << next.count_occupied_seats() << '\n';
 
     } while (next.room != pred.room);
@@ -176,22 +198,439 @@ struct GameOfLife {
     return next.count_occupied_seats();
   }
 
-  int converge_part2() const {
-    GameOfLife next(room);
-    auto pred = next;
+  int converge() const { return converge_with<Part1Rule>(); }
+
+  int converge_part2() const { return converge_with<Part2Rule>(); }
+
+  State at(Position& pos) const { return to_state(room.at(pos.row).at(pos.col)); }
+
+  Room room;
+};
+
+// generation barrier of the SeatGrid band workers
+struct Barrier {
+  explicit Barrier(int count) : count(count) {}
+
+  void arrive_and_wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    const int current = generation;
+    if (++arrived == count) {
+      arrived = 0;
+      generation++;
+      cv.notify_all();
+    } else {
+      cv.wait(lock, [this, current] { return generation != current; });
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  const int count;
+  int arrived{0};
+  int generation{0};
+};
+
+// the room in one contiguous byte buffer surrounded by a floor border: the 8 neighbours of any
+// cell are at fixed offsets, counting them needs no bounds check, no branch and no allocation
+struct SeatGrid {
+  enum Cell : uint8_t { FloorCell = 0, FreeSeat = 2, OccupiedSeat = 3 };  // bit 0 is occupancy
+
+  explicit SeatGrid(const Room& room)
+      : rows((int)room.size()),
+        cols(room.empty() ? 0 : (int)room.front().size()),
+        stride(cols + 2),
+        cells((rows + 2) * stride, FloorCell) {
+    for (int row = 0; row < rows; row++) {
+      for (int col = 0; col < cols; col++) {
+        cells[index(row, col)] = decode(room[row][col]);
+      }
+    }
+    next_cells = cells;
+  }
+
+  static uint8_t decode(char c) {
+    if (c == 'L')
+      return FreeSeat;
+    if (c == '#')
+      return OccupiedSeat;
+    return FloorCell;
+  }
+
+  static char encode(uint8_t cell) { return ".?L#"[cell]; }
+
+  int index(int row, int col) const { return (row + 1) * stride + col + 1; }
+
+  int count_occupied(int i) const {
+    const uint8_t* c = cells.data() + i;
+    return (c[-stride - 1] & 1) + (c[-stride] & 1) + (c[-stride + 1] & 1) + (c[-1] & 1) +
+           (c[1] & 1) + (c[stride - 1] & 1) + (c[stride] & 1) + (c[stride + 1] & 1);
+  }
+
+  // floor stays floor, seats follow the rule
+  template <typename Rule>
+  static uint8_t next_cell(uint8_t cell, int occupied) {
+    uint8_t is_seat = cell >> 1;
+    uint8_t occupied_next = Rule::occupied_next(cell & 1, occupied);
+    return (cell & FreeSeat) | (is_seat & occupied_next);
+  }
+
+  // writes the next generation in the second buffer and swaps them: no allocation, and the
+  // number of changed cells returned tells if the fixed point is reached
+  int step() {
+    int changed = step_rows(0, rows);
+    cells.swap(next_cells);
+    return changed;
+  }
+
+  // writes rows [first_row, last_row) of the next generation, without swapping the buffers.
+  // Dense path of the adjacent rules: neighbours at fixed offsets, no table
+  template <typename Rule = Part1Rule>
+  int step_rows(int first_row, int last_row) {
+    static_assert(Rule::neighbourhood == Neighbourhood::Adjacent);
+    int changed = 0;
+    for (int row = first_row; row < last_row; row++) {
+      const int first = index(row, 0);
+      for (int i = first; i < first + cols; i++) {
+        uint8_t cell = next_cell<Rule>(cells[i], count_occupied(i));
+        changed += (cell != cells[i]);
+        next_cells[i] = cell;
+      }
+    }
+    return changed;
+  }
+
+  SeatGrid next_round() const {
+    SeatGrid next(*this);
+    next.step();
+    return next;
+  }
+
+  int converge() const {
+    SeatGrid grid(*this);
+    while (grid.step() != 0) {
+    }
+    return grid.count_occupied_seats();
+  }
+
+  // part 2: the floor never changes, so the seat seen in each direction is resolved once per room
+  // in a fixed width table of 8 cell indices per seat. A direction without seat points to the
+  // border cell 0, which is always floor. With the adjacent neighbourhood it holds the 8 adjacent
+  // cells, so that any rule can run on the table
+  struct SightTable {
+    explicit SightTable(const SeatGrid& grid,
+                        Neighbourhood neighbourhood = Neighbourhood::LineOfSight) {
+      const bool line_of_sight = neighbourhood == Neighbourhood::LineOfSight;
+      const int directions[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1},
+                                    {0, 1},   {1, -1}, {1, 0},  {1, 1}};
+      for (int row = 0; row < grid.rows; row++) {
+        for (int col = 0; col < grid.cols; col++) {
+          if (grid.cells[grid.index(row, col)] == FloorCell)
+            continue;
+          seats.push_back(grid.index(row, col));
+          for (auto [dr, dc] : directions) {
+            int r = row + dr;
+            int c = col + dc;
+            while (line_of_sight && r >= 0 && r < grid.rows && c >= 0 && c < grid.cols &&
+                   grid.cells[grid.index(r, c)] == FloorCell) {
+              r += dr;
+              c += dc;
+            }
+            bool inside = r >= 0 && r < grid.rows && c >= 0 && c < grid.cols;
+            visible.push_back(inside ? grid.index(r, c) : 0);
+          }
+        }
+      }
+    }
+
+    int visible_occupied(const SeatGrid& grid, std::size_t seat) const {
+      const int* v = visible.data() + 8 * seat;
+      const uint8_t* c = grid.cells.data();
+      return (c[v[0]] & 1) + (c[v[1]] & 1) + (c[v[2]] & 1) + (c[v[3]] & 1) + (c[v[4]] & 1) +
+             (c[v[5]] & 1) + (c[v[6]] & 1) + (c[v[7]] & 1);
+    }
+
+    std::vector<int> seats;    // cell index of each seat
+    std::vector<int> visible;  // 8 cell indices per seat
+  };
+
+  // part 2 round: a gather over the sight table, floor cells are never visited
+  int step_part2(const SightTable& sight) {
+    int changed = step_seats<Part2Rule>(sight, 0, sight.seats.size());
+    cells.swap(next_cells);
+    return changed;
+  }
+
+  template <typename Rule>
+  int step_seats(const SightTable& sight, std::size_t first_seat, std::size_t last_seat) {
+    int changed = 0;
+    for (std::size_t seat = first_seat; seat < last_seat; seat++) {
+      const int i = sight.seats[seat];
+      uint8_t cell = next_cell<Rule>(cells[i], sight.visible_occupied(*this, seat));
+      changed += (cell != cells[i]);
+      next_cells[i] = cell;
+    }
+    return changed;
+  }
+
+  // line of sight table of the room, built on first use and shared by the copies of the grid
+  // since the floor never changes
+  const SightTable& sight() const {
+    if (!sight_table) {
+      sight_table = std::make_shared<const SightTable>(*this);
+    }
+    return *sight_table;
+  }
+
+  SeatGrid next_round_part2() const {
+    SeatGrid next(*this);
+    next.step_part2(sight());
+    return next;
+  }
+
+  template <typename Rule>
+  int converge_with() const {
+    SeatGrid grid(*this);
+    const SightTable table{grid, Rule::neighbourhood};
+    int changed;
     do {
-      pred = next;
-      next = next.next_round_part2();
-      // std::cout << next.count_occupied_seats() << '\n';
+      changed = grid.step_seats<Rule>(table, 0, table.seats.size());
+      grid.cells.swap(grid.next_cells);
+    } while (changed != 0);
+    return grid.count_occupied_seats();
+  }
 
-    } while (next.room != pred.room);
+  int converge_part2() const { return converge_with<Part2Rule>(); }
+
+  // worklist mode: a cell can only change when itself or one of its neighbours changed in the
+  // previous round, so only those cells are evaluated again. Updates are applied in place once
+  // the whole frontier is evaluated
+  template <typename Rule>
+  int converge_frontier_with() const {
+    SeatGrid grid(*this);
+    const SightTable table{grid, Rule::neighbourhood};
+    std::vector<int> seat_of_cell(cells.size(), -1);
+    for (std::size_t seat = 0; seat < table.seats.size(); seat++) {
+      seat_of_cell[table.seats[seat]] = (int)seat;
+    }
 
-    return next.count_occupied_seats();
+    std::vector<int> frontier = table.seats;
+    std::vector<int> queued_at(cells.size(), -1);
+    std::vector<std::pair<int, uint8_t>> updates;
+    for (int generation = 0; !frontier.empty(); generation++) {
+      updates.clear();
+      for (int i : frontier) {
+        uint8_t cell =
+            next_cell<Rule>(grid.cells[i], table.visible_occupied(grid, seat_of_cell[i]));
+        if (cell != grid.cells[i])
+          updates.emplace_back(i, cell);
+      }
+
+      frontier.clear();
+      auto enqueue = [&](int i) {
+        if (queued_at[i] != generation && grid.cells[i] != FloorCell) {
+          queued_at[i] = generation;
+          frontier.push_back(i);
+        }
+      };
+      for (auto [i, cell] : updates) {
+        grid.cells[i] = cell;
+        enqueue(i);
+        for (int k = 0; k < 8; k++) {
+          enqueue(table.visible[8 * seat_of_cell[i] + k]);
+        }
+      }
+    }
+    return grid.count_occupied_seats();
   }
 
-  State at(Position& pos) const { return to_state(room.at(pos.row).at(pos.col)); }
+  int converge_frontier() const { return converge_frontier_with<Part1Rule>(); }
+
+  int converge_part2_frontier() const { return converge_frontier_with<Part2Rule>(); }
+
+  // parallel stepping: every worker owns a band and writes only its cells of the next buffer.
+  // A barrier separates the generations, the changed flags of the bands are OR-reduced between
+  // them, so the result is the same as the sequential one
+  template <typename StepBand>
+  void converge_in_bands(int threads, StepBand step_band) {
+    threads = std::max(1, threads);
+    std::vector<int> band_changed(threads, 0);
+    bool done = false;
+    Barrier barrier(threads);
+
+    auto worker = [&](int band) {
+      while (true) {
+        band_changed[band] = step_band(band, threads);
+        barrier.arrive_and_wait();
+        if (band == 0) {
+          cells.swap(next_cells);
+          done = ranges::count(band_changed, 0) == threads;
+        }
+        barrier.arrive_and_wait();
+        if (done)
+          return;
+      }
+    };
 
-  Room room;
+    std::vector<std::thread> pool;
+    for (int band = 1; band < threads; band++) {
+      pool.emplace_back(worker, band);
+    }
+    worker(0);
+    for (auto& thread : pool) {
+      thread.join();
+    }
+  }
+
+  int converge_parallel(int threads = std::thread::hardware_concurrency()) const {
+    SeatGrid grid(*this);
+    grid.converge_in_bands(threads, [&grid](int band, int bands) {
+      return grid.step_rows(grid.rows * band / bands, grid.rows * (band + 1) / bands);
+    });
+    return grid.count_occupied_seats();
+  }
+
+  template <typename Rule>
+  int converge_parallel_with(int threads = std::thread::hardware_concurrency()) const {
+    SeatGrid grid(*this);
+    const SightTable table{grid, Rule::neighbourhood};
+    const std::size_t seats = table.seats.size();
+    grid.converge_in_bands(threads, [&grid, &table, seats](int band, int bands) {
+      return grid.step_seats<Rule>(table, seats * band / bands, seats * (band + 1) / bands);
+    });
+    return grid.count_occupied_seats();
+  }
+
+  int converge_part2_parallel(int threads = std::thread::hardware_concurrency()) const {
+    return converge_parallel_with<Part2Rule>(threads);
+  }
+
+  int count_occupied_seats() const { return (int)ranges::count(cells, OccupiedSeat); }
+
+  Room room() const {
+    Room room(rows, std::string(cols, '.'));
+    for (int row = 0; row < rows; row++) {
+      for (int col = 0; col < cols; col++) {
+        room[row][col] = encode(cells[index(row, col)]);
+      }
+    }
+    return room;
+  }
+
+  int rows;
+  int cols;
+  int stride;
+  std::vector<uint8_t> cells;
+  std::vector<uint8_t> next_cells;  // same border as cells, inner cells overwritten by step()
+  mutable std::shared_ptr<const SightTable> sight_table;
+};
+
+// part 1 on bitplanes: one bit per cell, 64 cells per word. The 8 neighbour occupancy words are
+// summed with bit sliced adders, so the rule is evaluated for a whole word with boolean logic
+struct SeatBitplanes {
+  explicit SeatBitplanes(const Room& room)
+      : rows((int)room.size()),
+        cols(room.empty() ? 0 : (int)room.front().size()),
+        words((cols + 63) / 64),
+        stride(words + 2),
+        seats((rows + 2) * stride, 0),
+        occupied(seats.size(), 0),
+        next_occupied(seats.size(), 0) {
+    for (int row = 0; row < rows; row++) {
+      for (int col = 0; col < cols; col++) {
+        const uint64_t bit = 1ull << (col % 64);
+        const int w = word(row, col / 64);
+        if (room[row][col] != '.')
+          seats[w] |= bit;
+        if (room[row][col] == '#')
+          occupied[w] |= bit;
+      }
+    }
+  }
+
+  // rows and words are surrounded by zero padding
+  int word(int row, int w) const { return (row + 1) * stride + w + 1; }
+
+  // neighbour at col - 1 and col + 1 of each bit
+  static uint64_t west(const uint64_t* p) { return (p[0] << 1) | (p[-1] >> 63); }
+  static uint64_t east(const uint64_t* p) { return (p[0] >> 1) | (p[1] << 63); }
+
+  static void full_add(uint64_t a, uint64_t b, uint64_t c, uint64_t& sum, uint64_t& carry) {
+    const uint64_t t = a ^ b;
+    sum = t ^ c;
+    carry = (a & b) | (t & c);
+  }
+
+  static uint64_t next_word(const uint64_t* up,
+                            const uint64_t* mid,
+                            const uint64_t* down,
+                            uint64_t seat) {
+    // 8 one bit inputs to a 4 bit count: ones, twos and fours (the eights is fours too)
+    uint64_t s1, c1, s2, c2, ones, c4, twos_sum, c5;
+    full_add(west(up), up[0], east(up), s1, c1);
+    full_add(west(down), down[0], east(down), s2, c2);
+    const uint64_t s3 = west(mid) ^ east(mid);
+    const uint64_t c3 = west(mid) & east(mid);
+    full_add(s1, s2, s3, ones, c4);
+    full_add(c1, c2, c3, twos_sum, c5);
+    const uint64_t twos = twos_sum ^ c4;
+    const uint64_t c6 = twos_sum & c4;
+    const uint64_t at_least_4 = c5 | c6;
+    const uint64_t none = ~(ones | twos | at_least_4);
+
+    const uint64_t occ = mid[0];
+    return seat & ((occ & ~at_least_4) | (~occ & none));
+  }
+
+  int step() {
+    int changed = 0;
+    for (int row = 0; row < rows; row++) {
+      for (int w = 0; w < words; w++) {
+        const int i = word(row, w);
+        const uint64_t next = next_word(&occupied[i - stride], &occupied[i],
+                                        &occupied[i + stride], seats[i]);
+        changed += (int)std::bitset<64>(next ^ occupied[i]).count();
+        next_occupied[i] = next;
+      }
+    }
+    occupied.swap(next_occupied);
+    return changed;
+  }
+
+  int converge() const {
+    SeatBitplanes planes(*this);
+    while (planes.step() != 0) {
+    }
+    return planes.count_occupied_seats();
+  }
+
+  int count_occupied_seats() const {
+    return ranges::accumulate(occupied, 0, [](int count, uint64_t w) {
+      return count + (int)std::bitset<64>(w).count();
+    });
+  }
+
+  Room room() const {
+    Room room(rows, std::string(cols, '.'));
+    for (int row = 0; row < rows; row++) {
+      for (int col = 0; col < cols; col++) {
+        const uint64_t bit = 1ull << (col % 64);
+        const int w = word(row, col / 64);
+        if (occupied[w] & bit)
+          room[row][col] = '#';
+        else if (seats[w] & bit)
+          room[row][col] = 'L';
+      }
+    }
+    return room;
+  }
+
+  int rows;
+  int cols;
+  int words;
+  int stride;
+  std::vector<uint64_t> seats;
+  std::vector<uint64_t> occupied;
+  std::vector<uint64_t> next_occupied;
 };
 
 TEST_CASE("Day 11: Seating System") {
@@ -312,6 +751,37 @@ L.#.L..#..
     // ----
     REQUIRE(gol.converge() == 37);
 
+    // ------ flat grid engine -------
+    SeatGrid grid{room};
+    REQUIRE(grid.room() == room);
+    REQUIRE(grid.count_occupied(grid.index(0, 0)) == 0);
+    REQUIRE(grid.next_round().next_round().room() == gol.next_round().next_round().room);
+    REQUIRE(grid.converge() == 37);
+
+    SeatGrid stepping{room};
+    int rounds = 0;
+    while (stepping.step() != 0) {
+      rounds++;
+    }
+    REQUIRE(rounds == 5);
+    REQUIRE(stepping.room() == expected);
+    REQUIRE(stepping.step() == 0);
+
+    REQUIRE(grid.converge_frontier() == 37);
+
+    for (int threads : {1, 3, 16}) {
+      REQUIRE(grid.converge_parallel(threads) == 37);
+    }
+
+    // ------ bit sliced engine -------
+    SeatBitplanes planes{room};
+    REQUIRE(planes.room() == room);
+    planes.step();
+    REQUIRE(planes.room() == gol.next_round().room);
+    planes.step();
+    REQUIRE(planes.room() == gol.next_round().next_round().room);
+    REQUIRE(planes.converge() == 37);
+
     // auto [number_of_one, number_of_three] = diff_and_find_number_of_1_and_3(numbers);
 
     // REQUIRE(number_of_one == 7);
@@ -322,6 +792,17 @@ L.#.L..#..
     GameOfLife gol{room};
 
     REQUIRE(gol.converge_part2() == 26);
+
+    SeatGrid grid{room};
+    REQUIRE(grid.next_round_part2().next_round_part2().room() ==
+            gol.next_round_part2().next_round_part2().room);
+    // the rounds reuse the sight table of the first grid
+    auto round = grid.next_round_part2();
+    REQUIRE(&round.sight() == &grid.sight());
+    REQUIRE(&round.next_round_part2().sight() == &grid.sight());
+    REQUIRE(grid.converge_part2() == 26);
+    REQUIRE(grid.converge_part2_parallel(4) == 26);
+    REQUIRE(grid.converge_part2_frontier() == 26);
   };
 };
 
@@ -335,6 +816,78 @@ TEST_CASE("day 11  ") {
   std::cout << " day 11 part 1 : " << gol.converge() << "\n";
 
   std::cout << " day 11 part 2 : " << gol.converge_part2() << "\n";
+
+  REQUIRE(SeatGrid{room}.converge() == gol.converge());
+  REQUIRE(SeatGrid{room}.converge_part2() == gol.converge_part2());
+  REQUIRE(SeatGrid{room}.converge_frontier() == gol.converge());
+  REQUIRE(SeatGrid{room}.converge_part2_frontier() == gol.converge_part2());
+
+  SeatGrid sequential{room};
+  while (sequential.step() != 0) {
+  }
+  SeatGrid parallel{room};
+  parallel.converge_in_bands(4, [&parallel](int band, int bands) {
+    return parallel.step_rows(parallel.rows * band / bands, parallel.rows * (band + 1) / bands);
+  });
+  REQUIRE(parallel.cells == sequential.cells);
+
+  SeatBitplanes planes{room};
+  while (planes.step() != 0) {
+  }
+  REQUIRE(planes.room() == sequential.room());
+}
+
+TEST_CASE("day 11 part 1 engines benchmark", "[.][benchmark]") {
+  std::ifstream in(DATA_DIR "/dataset/input_11.txt", std::ifstream::in);
+  REQUIRE(in.good());
+  auto room = parse_room(in);
+
+  // 10x10 copies of the input separated by floor, so that each copy converges as the input
+  Room large;
+  for (int copy = 0; copy < 10; copy++) {
+    for (const auto& line : room) {
+      large.push_back(ranges::accumulate(ranges::views::iota(0, 10), std::string{},
+                                         [&line](std::string l, int) { return l + line + '.'; }));
+    }
+    large.push_back(std::string(large.back().size(), '.'));
+  }
+
+  BENCHMARK("scalar count_occupied") { return GameOfLife{room}.converge(); };
+  BENCHMARK("byte grid") { return SeatGrid{room}.converge(); };
+  BENCHMARK("bit sliced") { return SeatBitplanes{room}.converge(); };
+  BENCHMARK("byte grid 10x10 room") { return SeatGrid{large}.converge(); };
+  BENCHMARK("bit sliced 10x10 room") { return SeatBitplanes{large}.converge(); };
+
+  REQUIRE(SeatBitplanes{large}.converge() == 100 * SeatBitplanes{room}.converge());
+}
+
+TEST_CASE("Day 11: seating rule policies") {
+  auto room = room_from_string(R"_(L.LL.LL.LL
+LLLLLLL.LL
+L.L.L..L..
+LLLL.LL.LL
+L.LL.LL.LL
+L.LLLLL.LL
+..L.L.....
+LLLLLLLLLL
+L.LLLLLL.L
+L.LLLLL.LL)_");
+
+  GameOfLife gol{room};
+  SeatGrid grid{room};
+
+  REQUIRE(grid.converge_with<Part1Rule>() == 37);
+  REQUIRE(grid.converge_with<Part2Rule>() == 26);
+
+  // a new rule plugs in every engine
+  using Crowded = SeatingRule<Neighbourhood::Adjacent, 1, 6>;
+  const int expected = gol.converge_with<Crowded>();
+  REQUIRE(grid.converge_with<Crowded>() == expected);
+  REQUIRE(grid.converge_frontier_with<Crowded>() == expected);
+  REQUIRE(grid.converge_parallel_with<Crowded>(3) == expected);
+
+  using FarSighted = SeatingRule<Neighbourhood::LineOfSight, 0, 4>;
+  REQUIRE(grid.converge_with<FarSighted>() == gol.converge_with<FarSighted>());
 }
 
 TEST_CASE("visible_occupied_seats") {
@@ -345,4 +898,28 @@ TEST_CASE("visible_occupied_seats") {
 
   REQUIRE(gol.visible_occupied_seats(Position{Col{1}, Row{1}}) == 0);
   REQUIRE(gol.visible_occupied_seats(Position{Col{3}, Row{1}}) == 1);
+
+  SeatGrid grid(room);
+  SeatGrid::SightTable sight(grid);
+  REQUIRE(sight.seats.size() == 6);
+  REQUIRE(sight.visible_occupied(grid, 0) == 0);
+  REQUIRE(sight.visible_occupied(grid, 1) == 1);
+  REQUIRE(sight.visible_occupied(grid, 2) == 1);
+  REQUIRE(sight.visible_occupied(grid, 3) == 2);
+}
+
+TEST_CASE("day 11 benchmark", "[.][benchmark][dataset]") {
+  std::ifstream in(DATA_DIR "/dataset/input_11.txt", std::ifstream::in);
+  const std::string text(std::istreambuf_iterator<char>(in), {});
+  std::istringstream parsed(text);
+  auto room = parse_room(parsed);
+
+  BENCHMARK("day 11 parse") {
+    std::istringstream input(text);
+    return parse_room(input);
+  };
+  BENCHMARK("day 11 part 1") { return GameOfLife{room}.converge(); };
+  BENCHMARK("day 11 part 2") { return GameOfLife{room}.converge_part2(); };
+  BENCHMARK("day 11 part 1 seat grid") { return SeatGrid{room}.converge(); };
+  BENCHMARK("day 11 part 2 seat grid") { return SeatGrid{room}.converge_part2(); };
 }
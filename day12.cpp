@@ -2,11 +2,14 @@
 #include <catch2/catch.hpp>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <list>
 #include <map>
 #include <range/v3/all.hpp>  // get everything
 #include <set>
 #include <sstream>
+#include <string_view>
+#include <thread>
 #include <variant>
 #include <vector>
 
@@ -169,6 +172,256 @@ int manhattan(const Pos& pos) {
   return std::abs(pos.easting) + std::abs(pos.northing);
 }
 
+// every command is an affine map of the (position, waypoint) state. In part 1 the waypoint is the
+// unit heading vector. Composing the maps is associative, so a log can be reduced in any grouping:
+//   position' = position + m * waypoint + a
+//   waypoint' = r * waypoint + c
+struct Navigation {
+  using Mat = std::array<long long, 4>;  // row major on (easting, northing)
+  using Vec = std::array<long long, 2>;
+
+  static Vec mul(const Mat& m, const Vec& v) {
+    return {m[0] * v[0] + m[1] * v[1], m[2] * v[0] + m[3] * v[1]};
+  }
+  static Mat mul(const Mat& a, const Mat& b) {
+    return {a[0] * b[0] + a[1] * b[2], a[0] * b[1] + a[1] * b[3], a[2] * b[0] + a[3] * b[2],
+            a[2] * b[1] + a[3] * b[3]};
+  }
+
+  // this map followed by next
+  Navigation then(const Navigation& next) const {
+    Navigation ret;
+    const Mat mr = mul(next.m, r);
+    ret.m = {m[0] + mr[0], m[1] + mr[1], m[2] + mr[2], m[3] + mr[3]};
+    const Vec mc = mul(next.m, c);
+    ret.a = {a[0] + mc[0] + next.a[0], a[1] + mc[1] + next.a[1]};
+    ret.r = mul(next.r, r);
+    const Vec rc = mul(next.r, c);
+    ret.c = {rc[0] + next.c[0], rc[1] + next.c[1]};
+    return ret;
+  }
+
+  // (position, waypoint) after the map, easting first. In 64 bits: the position of a long log
+  // leaves the int range of Pos
+  std::tuple<Vec, Vec> apply(const Vec& pos, const Vec& waypoint) const {
+    const Vec mw = mul(m, waypoint);
+    const Vec rw = mul(r, waypoint);
+    return {Vec{pos[0] + mw[0] + a[0], pos[1] + mw[1] + a[1]}, Vec{rw[0] + c[0], rw[1] + c[1]}};
+  }
+
+  Mat m{0, 0, 0, 0};
+  Mat r{1, 0, 0, 1};
+  Vec a{0, 0};
+  Vec c{0, 0};
+};
+
+long long manhattan(const Navigation::Vec& pos) {
+  return std::abs(pos[0]) + std::abs(pos[1]);
+}
+
+enum class Steering { Ship, Waypoint };
+
+Navigation to_navigation(Cmd cmd, Steering steering) {
+  Navigation nav;
+  Navigation::Vec move{0, 0};
+  switch (cmd.cmd) {
+    case 'N':
+      move = {0, cmd.val};
+      break;
+    case 'S':
+      move = {0, -cmd.val};
+      break;
+    case 'E':
+      move = {cmd.val, 0};
+      break;
+    case 'W':
+      move = {-cmd.val, 0};
+      break;
+    case 'F':
+      nav.m = {cmd.val, 0, 0, cmd.val};
+      return nav;
+    case 'L':
+    case 'R': {
+      if (cmd.val % 90 != 0) {
+        throw std::runtime_error("rotate " + std::to_string(cmd.val));
+      }
+      int quarters = ((cmd.cmd == 'R' ? cmd.val : -cmd.val) / 90 % 4 + 4) % 4;
+      for (int q = 0; q < quarters; q++) {
+        nav.r = Navigation::mul(Navigation::Mat{0, 1, -1, 0}, nav.r);  // clockwise
+      }
+      return nav;
+    }
+    default:
+      throw std::runtime_error("to navigation");
+  }
+  (steering == Steering::Ship ? nav.a : nav.c) = move;
+  return nav;
+}
+
+Navigation reduce_navigation(const Commands& cmds,
+                             Steering steering,
+                             std::size_t first,
+                             std::size_t last) {
+  Navigation nav;
+  for (std::size_t i = first; i < last; i++) {
+    nav = nav.then(to_navigation(cmds[i], steering));
+  }
+  return nav;
+}
+
+// each thread reduces a contiguous chunk, the chunk maps are then composed in order
+Navigation reduce_navigation_parallel(const Commands& cmds,
+                                      Steering steering,
+                                      int threads = std::thread::hardware_concurrency()) {
+  threads = std::max(1, threads);
+  std::vector<Navigation> chunks(threads);
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; t++) {
+    pool.emplace_back([&, t] {
+      chunks[t] = reduce_navigation(cmds, steering, cmds.size() * t / threads,
+                                    cmds.size() * (t + 1) / threads);
+    });
+  }
+  for (auto& thread : pool) {
+    thread.join();
+  }
+  return ranges::accumulate(chunks, Navigation{},
+                            [](const Navigation& acc, const Navigation& nav) {
+                              return acc.then(nav);
+                            });
+}
+
+// map of the first n commands of a log, from the reduced maps of its blocks. Owns its commands,
+// the tail of a block is reduced at query time
+struct NavigationPrefix {
+  NavigationPrefix(Commands commands, Steering steering, std::size_t block = 4096)
+      : cmds(std::move(commands)), steering(steering), block(block), block_prefix(1) {
+    for (std::size_t first = 0; first < cmds.size(); first += block) {
+      auto last = std::min(first + block, cmds.size());
+      auto nav = reduce_navigation(cmds, steering, first, last);
+      block_prefix.push_back(block_prefix.back().then(nav));
+    }
+  }
+
+  Navigation prefix(std::size_t n) const {
+    if (n > cmds.size()) {
+      throw std::out_of_range("prefix of " + std::to_string(n) + " commands out of " +
+                              std::to_string(cmds.size()));
+    }
+    const std::size_t b = n / block;
+    return block_prefix.at(b).then(reduce_navigation(cmds, steering, b * block, n));
+  }
+
+  Commands cmds;
+  Steering steering;
+  std::size_t block;
+  std::vector<Navigation> block_prefix;  // map of the first i blocks
+};
+
+// both parts in a single pass over the text of a log, without building Commands: the parser is a
+// state machine fed by chunks of any size, so the memory does not depend on the log length
+struct FusedNavigator {
+  // quarter turns clockwise from east
+  static constexpr std::array<long long, 4> east{1, 0, -1, 0};
+  static constexpr std::array<long long, 4> north{0, -1, 0, 1};
+  // waypoint rotation of q quarter turns clockwise, row major
+  static constexpr std::array<std::array<long long, 4>, 4> rotations{{
+      {1, 0, 0, 1},
+      {0, 1, -1, 0},
+      {-1, 0, 0, -1},
+      {0, -1, 1, 0},
+  }};
+
+  static int compass(char cmd) {
+    switch (cmd) {
+      case 'E':
+        return 0;
+      case 'S':
+        return 1;
+      case 'W':
+        return 2;
+      case 'N':
+        return 3;
+      default:
+        throw std::runtime_error(std::string("unknown action ") + cmd);
+    }
+  }
+
+  void step(char cmd, long long val) {
+    if (cmd == 'F') {
+      ship_e += val * east[heading];
+      ship_n += val * north[heading];
+      pos_e += val * wpt_e;
+      pos_n += val * wpt_n;
+    } else if (cmd == 'L' || cmd == 'R') {
+      if (val % 90 != 0) {
+        throw std::runtime_error("rotate " + std::to_string(val));
+      }
+      int quarters = (cmd == 'R' ? val / 90 : 4 - val / 90 % 4) % 4;
+      heading = (heading + quarters) % 4;
+      const auto& rot = rotations[quarters];
+      auto e = rot[0] * wpt_e + rot[1] * wpt_n;
+      wpt_n = rot[2] * wpt_e + rot[3] * wpt_n;
+      wpt_e = e;
+    } else {
+      const int dir = compass(cmd);
+      ship_e += val * east[dir];
+      ship_n += val * north[dir];
+      wpt_e += val * east[dir];
+      wpt_n += val * north[dir];
+    }
+  }
+
+  void feed(std::string_view chunk) {
+    for (char c : chunk) {
+      if (c >= '0' && c <= '9') {
+        val = val * 10 + (c - '0');
+      } else if (c == '\n' || c == '\r' || c == ' ' || c == '\t') {
+        finish();
+      } else {
+        finish();
+        cmd = c;
+      }
+    }
+  }
+
+  // executes the pending command, if any. Throws on an unknown action, a turn that is not a
+  // multiple of 90 or a value without action, like to_navigation
+  void finish() {
+    if (cmd != 0) {
+      step(cmd, val);
+    } else if (val != 0) {
+      throw std::runtime_error("value without action " + std::to_string(val));
+    }
+    cmd = 0;
+    val = 0;
+  }
+
+  void run(std::istream& in) {
+    std::array<char, 1 << 16> buffer;
+    while (in.read(buffer.data(), buffer.size()) || in.gcount() > 0) {
+      feed(std::string_view(buffer.data(), in.gcount()));
+    }
+    finish();
+  }
+
+  long long manhattan_part1() const { return std::abs(ship_e) + std::abs(ship_n); }
+  long long manhattan_part2() const { return std::abs(pos_e) + std::abs(pos_n); }
+
+  // part 1
+  long long ship_e{0};
+  long long ship_n{0};
+  int heading{0};
+  // part 2
+  long long pos_e{0};
+  long long pos_n{0};
+  long long wpt_e{10};
+  long long wpt_n{1};
+  // parser
+  char cmd{0};
+  long long val{0};
+};
+
 TEST_CASE("Day 12: Rain Risk") {
   std::string data(R"_(F10
 N3
@@ -228,6 +481,83 @@ F11)_");
 
     REQUIRE(manhattan(pos) == 286);
   }
+
+  SECTION("affine composition") {
+    using Vec = Navigation::Vec;
+    const Vec start{0, 0};
+    const Vec east{1, 0};
+    const Vec wpt{10, 1};
+
+    auto ship = reduce_navigation(cmds, Steering::Ship, 0, cmds.size());
+    auto [pos1, heading] = ship.apply(start, east);
+    REQUIRE(pos1 == Vec{17, -8});
+    REQUIRE(heading == Vec{0, -1});
+
+    auto [pos2, wpt2] = reduce_navigation_parallel(cmds, Steering::Waypoint, 3).apply(start, wpt);
+    REQUIRE(pos2 == Vec{214, -72});
+    REQUIRE(wpt2 == Vec{4, -10});
+
+    NavigationPrefix prefix(cmds, Steering::Waypoint, 2);
+    REQUIRE(std::get<0>(prefix.prefix(3).apply(start, wpt)) == Vec{170, 38});
+    REQUIRE(std::get<1>(prefix.prefix(4).apply(start, wpt)) == Vec{4, -10});
+    REQUIRE(std::get<0>(prefix.prefix(5).apply(start, wpt)) == pos2);
+    REQUIRE(prefix.prefix(0).apply(start, wpt) == std::make_tuple(start, wpt));
+    REQUIRE_THROWS_AS(prefix.prefix(6), std::out_of_range);
+
+    // built from a temporary
+    std::istringstream again{data};
+    NavigationPrefix owned(parse_pilot_commands(again), Steering::Waypoint, 2);
+    REQUIRE(std::get<0>(owned.prefix(5).apply(start, wpt)) == pos2);
+  }
+
+  SECTION("affine composition past int") {
+    // waypoint 10^6 + 10 east, 3000 forward moves: the easting reaches 3 * 10^12
+    std::string log = "E1000000\n";
+    for (int i = 0; i < 3000; i++) {
+      log += "F1000\n";
+    }
+    std::istringstream in{log};
+    NavigationPrefix prefix(parse_pilot_commands(in), Steering::Waypoint, 64);
+    auto [pos, wpt] = prefix.prefix(3001).apply({0, 0}, {10, 1});
+    REQUIRE(pos[0] > std::numeric_limits<int>::max());
+    REQUIRE(pos == Navigation::Vec{3000030000000ll, 3000000});
+    REQUIRE(wpt == Navigation::Vec{1000010, 1});
+
+    FusedNavigator fused;
+    fused.feed(log);
+    fused.finish();
+    REQUIRE(fused.manhattan_part2() == manhattan(pos));
+  }
+
+  SECTION("fused stream") {
+    FusedNavigator nav;
+    // chunks cut in the middle of the commands
+    for (std::size_t first = 0; first < data.size(); first += 3) {
+      nav.feed(std::string_view(data).substr(first, 3));
+    }
+    nav.finish();
+    REQUIRE(nav.manhattan_part1() == 25);
+    REQUIRE(nav.manhattan_part2() == 286);
+
+    FusedNavigator turns;
+    std::istringstream in_turns("R270\nF1\nL180\nF2\nR90\nF3\nL90");
+    turns.run(in_turns);
+    REQUIRE(turns.ship_e == -3);
+    REQUIRE(turns.ship_n == -1);
+    REQUIRE(turns.heading == 1);
+    REQUIRE(turns.wpt_e == 1);
+    REQUIRE(turns.wpt_n == -10);
+  }
+
+  SECTION("fused stream rejects what to_navigation rejects") {
+    for (Cmd bad : {Cmd{'R', 45}, Cmd{'L', 100}, Cmd{'X', 10}, Cmd{'f', 10}, Cmd{'-', 3}}) {
+      REQUIRE_THROWS_AS(to_navigation(bad, Steering::Ship), std::runtime_error);
+      REQUIRE_THROWS_AS(to_navigation(bad, Steering::Waypoint), std::runtime_error);
+      FusedNavigator nav;
+      std::istringstream in(std::string("F10\n") + bad.cmd + std::to_string(bad.val) + "\nF1\n");
+      REQUIRE_THROWS_AS(nav.run(in), std::runtime_error);
+    }
+  }
 };
 
 TEST_CASE("day 12 ") {
@@ -252,4 +582,71 @@ TEST_CASE("day 12 ") {
     }
     std::cout << " day 12 part 2 : " << manhattan(pos) << "\n";
   }
+  SECTION("fused stream") {
+    std::ifstream log(DATA_DIR "/dataset/input_12.txt", std::ifstream::in);
+    FusedNavigator nav;
+    nav.run(log);
+
+    Pos pos(Easting{0}, Northing{0}, Heading{90});
+    Pos ship = pos;
+    Pos wpt(Easting{10}, Northing{1});
+    for (auto& cmd : cmds) {
+      ship = execute(cmd, ship);
+      std::tie(pos, wpt) = execute_part2(cmd, pos, wpt);
+    }
+    REQUIRE(nav.manhattan_part1() == manhattan(ship));
+    REQUIRE(nav.manhattan_part2() == manhattan(pos));
+  }
+  SECTION("affine composition") {
+    const Pos start(Easting{0}, Northing{0}, Heading{90});
+    Pos pos = start;
+    Pos wpt(Easting{10}, Northing{1});
+    for (auto& cmd : cmds) {
+      std::tie(pos, wpt) = execute_part2(cmd, pos, wpt);
+    }
+    auto ship = reduce_navigation_parallel(cmds, Steering::Ship, 4);
+    auto waypoint = reduce_navigation_parallel(cmds, Steering::Waypoint, 4);
+
+    Pos part1 = start;
+    for (auto& cmd : cmds) {
+      part1 = execute(cmd, part1);
+    }
+    auto [ship_pos, heading] = ship.apply({0, 0}, {1, 0});
+    REQUIRE(manhattan(ship_pos) == manhattan(part1));
+    REQUIRE(std::get<0>(waypoint.apply({0, 0}, {10, 1})) ==
+            Navigation::Vec{pos.easting, pos.northing});
+  }
+}
+
+TEST_CASE("day 12 benchmark", "[.][benchmark][dataset]") {
+  std::ifstream in(DATA_DIR "/dataset/input_12.txt", std::ifstream::in);
+  const std::string text(std::istreambuf_iterator<char>(in), {});
+  std::istringstream parsed(text);
+  auto cmds = parse_pilot_commands(parsed);
+
+  BENCHMARK("day 12 parse") {
+    std::istringstream input(text);
+    return parse_pilot_commands(input);
+  };
+  BENCHMARK("day 12 part 1") {
+    Pos pos(Easting{0}, Northing{0}, Heading{90});
+    for (auto& cmd : cmds) {
+      pos = execute(cmd, pos);
+    }
+    return manhattan(pos);
+  };
+  BENCHMARK("day 12 part 2") {
+    Pos pos(Easting{0}, Northing{0}, Heading{90});
+    Pos wpt(Easting{10}, Northing{1});
+    for (auto& cmd : cmds) {
+      std::tie(pos, wpt) = execute_part2(cmd, pos, wpt);
+    }
+    return manhattan(pos);
+  };
+  BENCHMARK("day 12 both parts fused stream") {
+    FusedNavigator nav;
+    nav.feed(text);
+    nav.finish();
+    return nav.manhattan_part1() + nav.manhattan_part2();
+  };
 }
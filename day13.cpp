@@ -4,9 +4,13 @@
 #include <iostream>
 #include <list>
 #include <map>
+#include <numeric>
+#include <optional>
 #include <range/v3/all.hpp>  // get everything
 #include <set>
 #include <sstream>
+#include <string>
+#include <thread>
 #include <variant>
 #include <vector>
 
@@ -49,6 +53,90 @@ std::tuple<int, int> find_bus_id_and_wait(const Schedule& sched) {
   return {bus_id, wait};
 }
 
+// schedule prepared for many departure queries: every frequency keeps its Barrett reciprocal
+// floor(2^32 / freq), so t % freq is a multiplication, a shift and one correction for any 32 bit t
+struct DepartureIndex {
+  static constexpr std::size_t block = 256;
+
+  explicit DepartureIndex(const Schedule& sched) {
+    for (auto id : sched.freq) {
+      freqs.push_back(id);
+      reciprocals.push_back(id == 1 ? 0xffffffffu : static_cast<uint32_t>((1ull << 32) / id));
+    }
+  }
+
+  uint32_t wait_for(std::size_t bus, uint32_t departure) const {
+    const uint32_t freq = freqs[bus];
+    uint32_t rem = departure - ((uint64_t{departure} * reciprocals[bus]) >> 32) * freq;
+    rem -= rem >= freq ? freq : 0;
+    return rem == 0 ? 0 : freq - rem;
+  }
+
+  // same answer as find_bus_id_and_wait, the first bus wins ties
+  std::tuple<int, int> next_bus(uint32_t departure) const {
+    std::size_t best = 0;
+    uint32_t wait = std::numeric_limits<uint32_t>::max();
+    for (std::size_t bus = 0; bus < freqs.size(); bus++) {
+      auto w = wait_for(bus, departure);
+      best = w < wait ? bus : best;
+      wait = std::min(w, wait);
+    }
+    return {static_cast<int>(freqs[best]), static_cast<int>(wait)};
+  }
+
+  // bus after bus over a block of queries. The block is copied to a local array and padded, so the
+  // inner loop has a constant trip count and no aliasing: gcc vectorises it at -O2 already
+  void next_buses(const uint32_t* departures, std::size_t n, std::tuple<int, int>* answers) const {
+    std::array<uint32_t, block> t, wait, best;
+    for (std::size_t first = 0; first < n; first += block) {
+      const auto count = std::min(block, n - first);
+      std::copy(departures + first, departures + first + count, t.begin());
+      std::fill(t.begin() + count, t.end(), 0);
+      wait.fill(std::numeric_limits<uint32_t>::max());
+      best.fill(0);
+      for (uint32_t bus = 0; bus < freqs.size(); bus++) {
+        const uint32_t freq = freqs[bus];
+        const uint64_t reciprocal = reciprocals[bus];
+        for (std::size_t i = 0; i < block; i++) {
+          // selects through masks, branches keep the loop from vectorising
+          uint32_t rem = t[i] - static_cast<uint32_t>((t[i] * reciprocal) >> 32) * freq;
+          rem -= freq & -static_cast<uint32_t>(rem >= freq);
+          const uint32_t w = (freq - rem) & -static_cast<uint32_t>(rem != 0);
+          const uint32_t less = -static_cast<uint32_t>(w < wait[i]);
+          best[i] = (bus & less) | (best[i] & ~less);
+          wait[i] = (w & less) | (wait[i] & ~less);
+        }
+      }
+      for (std::size_t i = 0; i < count; i++) {
+        answers[first + i] = {static_cast<int>(freqs[best[i]]), static_cast<int>(wait[i])};
+      }
+    }
+  }
+
+  // each thread answers a contiguous chunk of the queries
+  std::vector<std::tuple<int, int>> next_buses(
+      const std::vector<uint32_t>& departures,
+      int threads = std::thread::hardware_concurrency()) const {
+    threads = std::max(1, threads);
+    std::vector<std::tuple<int, int>> answers(departures.size());
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+      pool.emplace_back([&, t] {
+        auto first = departures.size() * t / threads;
+        auto last = departures.size() * (t + 1) / threads;
+        next_buses(departures.data() + first, last - first, answers.data() + first);
+      });
+    }
+    for (auto& thread : pool) {
+      thread.join();
+    }
+    return answers;
+  }
+
+  std::vector<uint32_t> freqs;
+  std::vector<uint32_t> reciprocals;
+};
+
 TEST_CASE("Day 13: Shuttle Search") {
   std::string data(R"_(939
 7,13,x,x,59,x,31,19)_");
@@ -63,8 +151,51 @@ TEST_CASE("Day 13: Shuttle Search") {
     REQUIRE(bus_id == 59);
     REQUIRE(wait == 5);
   }
+
+  SECTION("departure index") {
+    DepartureIndex index(cmds);
+    REQUIRE(index.next_bus(939) == std::make_tuple(59, 5));
+
+    std::vector<uint32_t> departures;
+    for (uint32_t departure = 0; departure < 5000; departure++) {
+      departures.push_back(departure * 7919);
+    }
+    auto answers = index.next_buses(departures, 3);
+    Schedule sched = cmds;
+    for (std::size_t i = 0; i < departures.size(); i++) {
+      sched.departure = departures[i];
+      REQUIRE(answers[i] == find_bus_id_and_wait(sched));
+    }
+
+    // 2^32 - 1 = 3 (mod 7), 8 (mod 13), 50 (mod 59), 3 (mod 31), 5 (mod 19)
+    REQUIRE(index.next_bus(std::numeric_limits<uint32_t>::max()) == std::make_tuple(7, 4));
+  }
 };
 
+TEST_CASE("Day 13: departure index benchmark", "[.][benchmark]") {
+  std::ifstream in(DATA_DIR "/dataset/input_13.txt", std::ifstream::in);
+  DepartureIndex index(parse_bus_schedule(in));
+
+  std::vector<uint32_t> departures(1000000);
+  uint64_t seed = 42;
+  for (auto& departure : departures) {
+    seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+    // find_bus_id_and_wait takes an int
+    departure = static_cast<uint32_t>(seed >> 33);
+  }
+
+  BENCHMARK("10^6 queries, division") {
+    Schedule sched{0, {index.freqs.begin(), index.freqs.end()}};
+    int sum = 0;
+    for (auto departure : departures) {
+      sched.departure = departure;
+      sum += std::get<1>(find_bus_id_and_wait(sched));
+    }
+    return sum;
+  };
+  BENCHMARK("10^6 queries, reciprocals") { return index.next_buses(departures).size(); };
+}
+
 TEST_CASE("day 13 part 1 ") {
   std::ifstream in(DATA_DIR "/dataset/input_13.txt", std::ifstream::in);
   REQUIRE(in.good());
@@ -206,4 +337,248 @@ TEST_CASE("day 13 part2 ") {
   auto busses = parse_bus_schedule2(in);
 
   std::cout << " day 13 part 2 : " << day13part2(busses) << "\n";
-}
\ No newline at end of file
+}
+
+// t = residue (mod modulus)
+struct Congruence {
+  unsigned long long residue;
+  unsigned long long modulus;
+};
+
+std::vector<Congruence> to_congruences(const std::vector<Bus>& busses) {
+  std::vector<Congruence> congruences;
+  for (const auto& bus : busses) {
+    unsigned long long freq = bus.freq;
+    congruences.push_back({(freq - bus.offset % freq) % freq, freq});
+  }
+  return congruences;
+}
+
+// unbounded natural number, base 2^32 little endian limbs, only what the crt needs. Same limbs
+// as BigUnsigned of day 10, which is private to day10.cpp and has no % or * by a 64 bits word
+struct LongNatural {
+  LongNatural(unsigned __int128 value = 0) {
+    for (; value != 0; value >>= 32) {
+      limbs.push_back(static_cast<uint32_t>(value));
+    }
+  }
+
+  unsigned long long operator%(unsigned long long mod) const {
+    unsigned __int128 rem = 0;
+    for (auto it = limbs.rbegin(); it != limbs.rend(); ++it) {
+      rem = ((rem << 32) | *it) % mod;
+    }
+    return static_cast<unsigned long long>(rem);
+  }
+
+  LongNatural operator*(unsigned long long factor) const {
+    LongNatural product;
+    unsigned __int128 carry = 0;
+    for (auto limb : limbs) {
+      carry += static_cast<unsigned __int128>(limb) * factor;
+      product.limbs.push_back(static_cast<uint32_t>(carry));
+      carry >>= 32;
+    }
+    for (; carry != 0; carry >>= 32) {
+      product.limbs.push_back(static_cast<uint32_t>(carry));
+    }
+    product.trim();
+    return product;
+  }
+
+  LongNatural& operator+=(const LongNatural& other) {
+    limbs.resize(std::max(limbs.size(), other.limbs.size()), 0);
+    unsigned long long carry = 0;
+    for (std::size_t i = 0; i < limbs.size(); i++) {
+      carry += limbs[i];
+      if (i < other.limbs.size()) {
+        carry += other.limbs[i];
+      }
+      limbs[i] = static_cast<uint32_t>(carry);
+      carry >>= 32;
+    }
+    if (carry != 0) {
+      limbs.push_back(static_cast<uint32_t>(carry));
+    }
+    return *this;
+  }
+
+  bool operator==(const LongNatural& other) const { return limbs == other.limbs; }
+
+  void trim() {
+    while (!limbs.empty() && limbs.back() == 0) {
+      limbs.pop_back();
+    }
+  }
+
+  std::vector<uint32_t> limbs;
+};
+
+std::string to_string(LongNatural value) {
+  std::string digits;
+  do {
+    // divide in place by 10^9
+    unsigned long long rem = 0;
+    for (auto it = value.limbs.rbegin(); it != value.limbs.rend(); ++it) {
+      rem = (rem << 32) | *it;
+      *it = static_cast<uint32_t>(rem / 1000000000);
+      rem %= 1000000000;
+    }
+    value.trim();
+    auto chunk = std::to_string(rem);
+    if (!value.limbs.empty()) {
+      chunk.insert(0, 9 - chunk.size(), '0');
+    }
+    digits.insert(0, chunk);
+  } while (!value.limbs.empty());
+  return digits;
+}
+
+// inverse of a modulo mod, a and mod coprime
+unsigned long long inverse_mod(unsigned long long a, unsigned long long mod) {
+  __int128 r0 = mod, r1 = a % mod, s0 = 0, s1 = 1;
+  while (r1 != 0) {
+    auto q = r0 / r1;
+    std::tie(r0, r1) = std::make_tuple(r1, r0 - q * r1);
+    std::tie(s0, s1) = std::make_tuple(s1, s0 - q * s1);
+  }
+  s0 %= static_cast<__int128>(mod);
+  return static_cast<unsigned long long>(s0 < 0 ? s0 + mod : s0);
+}
+
+// folds a congruence into t = residue (mod modulus), the moduli do not need to be coprime:
+// t = residue + modulus * k with (modulus / g) * k = (r - residue) / g (mod m / g)
+template <typename Number>
+bool crt_step(Number& residue, Number& modulus, const Congruence& congruence) {
+  const auto m = congruence.modulus;
+  const unsigned long long modulus_mod_m = modulus % m;
+  const unsigned long long residue_mod_m = residue % m;
+  const auto g = std::gcd(modulus_mod_m, m);
+  const auto diff = (congruence.residue % m + m - residue_mod_m) % m;
+  if (diff % g != 0) {
+    return false;
+  }
+  const auto step = m / g;
+  const auto k = static_cast<unsigned long long>(static_cast<unsigned __int128>(diff / g) *
+                                                 inverse_mod(modulus_mod_m / g, step) % step);
+  residue += modulus * k;
+  modulus = modulus * step;
+  return true;
+}
+
+// the combined congruence, modulus being the lcm of all the moduli
+struct CrtSolution {
+  LongNatural residue;
+  LongNatural modulus;
+};
+
+// 128 bit arithmetic while the lcm fits, arbitrary precision after
+// nullopt when two congruences contradict each other
+std::optional<CrtSolution> solve_crt(const std::vector<Congruence>& congruences) {
+  unsigned __int128 residue = 0, modulus = 1;
+  std::size_t i = 0;
+  for (; i < congruences.size(); i++) {
+    const auto m = congruences[i].modulus;
+    if (modulus > ~static_cast<unsigned __int128>(0) / m) {
+      break;
+    }
+    if (!crt_step(residue, modulus, congruences[i])) {
+      return std::nullopt;
+    }
+  }
+
+  CrtSolution solution{residue, modulus};
+  for (; i < congruences.size(); i++) {
+    if (!crt_step(solution.residue, solution.modulus, congruences[i])) {
+      return std::nullopt;
+    }
+  }
+  return solution;
+}
+
+std::string day13part2_crt(const std::vector<Bus>& busses) {
+  auto solution = solve_crt(to_congruences(busses));
+  if (!solution) {
+    throw std::runtime_error("no departure matches the schedule");
+  }
+  return to_string(solution->residue);
+}
+
+TEST_CASE("Day 13: chinese remainder") {
+  SECTION("examples") {
+    REQUIRE(day13part2_crt({{17, 0}, {13, 2}, {19, 3}}) == "3417");
+    REQUIRE(day13part2_crt({{67, 0}, {7, 2}, {59, 3}, {61, 4}}) == "779210");
+    REQUIRE(day13part2_crt({{1789, 0}, {37, 1}, {47, 2}, {1889, 3}}) == "1202161486");
+    std::istringstream in{"939\n7,13,x,x,59,x,31,19"};
+    REQUIRE(day13part2_crt(parse_bus_schedule2(in)) == "1068781");
+  }
+
+  SECTION("non coprime moduli") {
+    auto solution = solve_crt({{2, 4}, {4, 6}});
+    REQUIRE(solution);
+    REQUIRE(to_string(solution->residue) == "10");
+    REQUIRE(to_string(solution->modulus) == "12");
+
+    REQUIRE_FALSE(solve_crt({{1, 4}, {2, 6}}));
+  }
+
+  SECTION("beyond 128 bits") {
+    // the first 300 primes, t = i (mod p_i)
+    std::vector<Congruence> congruences;
+    for (unsigned long long n = 2; congruences.size() < 300; n++) {
+      bool prime = true;
+      for (unsigned long long d = 2; d * d <= n; d++) {
+        prime = prime && n % d != 0;
+      }
+      if (prime) {
+        congruences.push_back({congruences.size() % n, n});
+      }
+    }
+    auto solution = solve_crt(congruences);
+    REQUIRE(solution);
+    REQUIRE(solution->modulus.limbs.size() > 4);
+    for (const auto& congruence : congruences) {
+      REQUIRE(solution->residue % congruence.modulus == congruence.residue);
+      REQUIRE(solution->modulus % congruence.modulus == 0);
+    }
+  }
+
+  SECTION("to string") {
+    REQUIRE(to_string(LongNatural{}) == "0");
+    REQUIRE(to_string(LongNatural{1000000000}) == "1000000000");
+    REQUIRE(to_string(LongNatural{~static_cast<unsigned __int128>(0)}) ==
+            "340282366920938463463374607431768211455");
+  }
+}
+
+TEST_CASE("day 13 part2 crt") {
+  std::ifstream in(DATA_DIR "/dataset/input_13.txt", std::ifstream::in);
+  REQUIRE(in.good());
+
+  auto busses = parse_bus_schedule2(in);
+
+  REQUIRE(day13part2_crt(busses) == std::to_string(day13part2(busses)));
+}
+
+TEST_CASE("day 13 benchmark", "[.][benchmark][dataset]") {
+  std::ifstream in(DATA_DIR "/dataset/input_13.txt", std::ifstream::in);
+  const std::string text(std::istreambuf_iterator<char>(in), {});
+  std::istringstream parsed(text), parsed2(text);
+  auto sched = parse_bus_schedule(parsed);
+  auto busses = parse_bus_schedule2(parsed2);
+
+  BENCHMARK("day 13 parse") {
+    std::istringstream input(text);
+    return parse_bus_schedule(input);
+  };
+  BENCHMARK("day 13 parse part 2") {
+    std::istringstream input(text);
+    return parse_bus_schedule2(input);
+  };
+  BENCHMARK("day 13 part 1") { return find_bus_id_and_wait(sched); };
+  BENCHMARK("day 13 part 2") {
+    auto copy = busses;
+    return day13part2(copy);
+  };
+  BENCHMARK("day 13 part 2 crt") { return day13part2_crt(busses); };
+}
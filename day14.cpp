@@ -3,11 +3,15 @@
 #include <catch2/catch.hpp>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <list>
 #include <map>
 #include <range/v3/all.hpp>  // get everything
 #include <set>
 #include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
 #include <variant>
 #include <vector>
 using namespace std::literals::string_literals;
@@ -95,45 +99,401 @@ struct Mask {
   std::string mask;
 };
 
+// integer form of the part 2 mask: forced ones and floating bits, the floating addresses are the
+// submasks of the floating bits, enumerated with s = (s - floating) & floating
+struct FloatingMask {
+  explicit FloatingMask(const Mask& mask)
+      : ones(mask.or_bitset.to_ullong()),
+        floating((mask.and_bitset & ~mask.or_bitset).to_ullong()) {}
+  FloatingMask(uint64_t ones, uint64_t floating) : ones(ones), floating(floating) {}
+
+  // part 1: same as Mask::apply
+  unsigned long apply(unsigned long value) const { return (value | ones) & (ones | floating); }
+
+  template <typename Callback>
+  void for_each_address(uint64_t address, Callback&& callback) const {
+    const uint64_t base = (address | ones) & ~floating;
+    uint64_t sub = 0;
+    do {
+      callback(base | sub);
+      sub = (sub - floating) & floating;
+    } while (sub != 0);
+  }
+
+  uint64_t ones;
+  uint64_t floating;
+};
+
 struct Operations {
   explicit Operations(Mask m) : mask(m) {}
 
   struct Op {
-    int address;
+    uint64_t address;
     unsigned long value;
   };
   Mask mask;
   std::vector<Op> ops;
 };
 
+// 16 byte record of a program line. A mask sets bit 63 of the first word and keeps its forced ones
+// there, its floating bits in the second. A write keeps its address and value
+struct DockingRecord {
+  static constexpr uint64_t mask_flag = 1ull << 63;
+
+  static DockingRecord mask(uint64_t ones, uint64_t floating) {
+    return {ones | mask_flag, floating};
+  }
+  static DockingRecord write(uint64_t address, uint64_t value) { return {address, value}; }
+
+  bool is_mask() const { return (first & mask_flag) != 0; }
+  FloatingMask floating_mask() const { return {first & ~mask_flag, second}; }
+  uint64_t address() const { return first; }
+  unsigned long value() const { return second; }
+
+  uint64_t first;
+  uint64_t second;
+};
+static_assert(sizeof(DockingRecord) == 16);
+
+// visit(mask, address, value) for every write, in program order or backwards. The engines below
+// take either the Operations of read_operations or the records of parse_docking_records
+template <typename Visitor>
+void for_each_write(const std::vector<Operations>& ops_batch, Visitor&& visit) {
+  for (const Operations& ops : ops_batch) {
+    const FloatingMask mask(ops.mask);
+    for (const Operations::Op& op : ops.ops) {
+      visit(mask, op.address, op.value);
+    }
+  }
+}
+
+template <typename Visitor>
+void for_each_write_backwards(const std::vector<Operations>& ops_batch, Visitor&& visit) {
+  for (auto ops = ops_batch.rbegin(); ops != ops_batch.rend(); ++ops) {
+    const FloatingMask mask(ops->mask);
+    for (auto op = ops->ops.rbegin(); op != ops->ops.rend(); ++op) {
+      visit(mask, op->address, op->value);
+    }
+  }
+}
+
+template <typename Visitor>
+void for_each_write(const std::vector<DockingRecord>& records, Visitor&& visit) {
+  FloatingMask mask{0, 0};
+  for (const auto& record : records) {
+    if (record.is_mask()) {
+      mask = record.floating_mask();
+    } else {
+      visit(mask, record.address(), record.value());
+    }
+  }
+}
+
+// a block of writes runs back to its mask
+template <typename Visitor>
+void for_each_write_backwards(const std::vector<DockingRecord>& records, Visitor&& visit) {
+  for (std::size_t last = records.size(); last > 0;) {
+    std::size_t first = last;
+    while (first > 0 && !records[first - 1].is_mask()) {
+      first--;
+    }
+    const FloatingMask mask = first > 0 ? records[first - 1].floating_mask() : FloatingMask{0, 0};
+    for (std::size_t i = last; i > first; i--) {
+      visit(mask, records[i - 1].address(), records[i - 1].value());
+    }
+    last = first > 0 ? first - 1 : 0;
+  }
+}
+
+// open addressing with linear probing over 36 bit addresses, ~0 marks an empty slot. Empty slots
+// keep a zero value so the sum is a sweep of the value array
+struct MemoryTable {
+  static constexpr uint64_t empty = ~0ull;
+
+  // room for n addresses at a load factor of at most 1/2
+  void reserve(std::size_t n) {
+    std::size_t capacity = 16;
+    while (capacity < 2 * n) {
+      capacity *= 2;
+    }
+    if (capacity <= keys.size()) {
+      return;
+    }
+    auto old_keys = std::move(keys);
+    auto old_values = std::move(values);
+    keys.assign(capacity, empty);
+    values.assign(capacity, 0);
+    shift = 64;
+    for (; capacity > 1; capacity /= 2) {
+      shift--;
+    }
+    for (std::size_t i = 0; i < old_keys.size(); i++) {
+      if (old_keys[i] != empty) {
+        auto slot = probe(old_keys[i]);
+        keys[slot] = old_keys[i];
+        values[slot] = old_values[i];
+      }
+    }
+  }
+
+  unsigned long& operator[](uint64_t address) {
+    if (2 * (count + 1) > keys.size()) {
+      reserve(count + 1);
+    }
+    auto i = probe(address);
+    if (keys[i] == empty) {
+      keys[i] = address;
+      count++;
+    }
+    return values[i];
+  }
+
+  // stores the value unless the address is already there, in a single probe. Returns whether it did
+  bool insert(uint64_t address, unsigned long value) {
+    if (2 * (count + 1) > keys.size()) {
+      reserve(count + 1);
+    }
+    auto i = probe(address);
+    if (keys[i] != empty) {
+      return false;
+    }
+    keys[i] = address;
+    values[i] = value;
+    count++;
+    return true;
+  }
+
+  const unsigned long* find(uint64_t address) const {
+    if (keys.empty()) {
+      return nullptr;
+    }
+    auto i = probe(address);
+    return keys[i] == empty ? nullptr : &values[i];
+  }
+
+  std::size_t size() const { return count; }
+
+  unsigned long long sum() const { return ranges::accumulate(values, 0ull); }
+
+  bool operator==(const MemoryTable& other) const {
+    if (count != other.count) {
+      return false;
+    }
+    for (std::size_t i = 0; i < keys.size(); i++) {
+      if (keys[i] != empty) {
+        auto value = other.find(keys[i]);
+        if (value == nullptr || *value != values[i]) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  // slot of the address, or the empty slot where it belongs
+  std::size_t probe(uint64_t address) const {
+    std::size_t i = (address * 0x9E3779B97F4A7C15ull) >> shift;
+    while (keys[i] != empty && keys[i] != address) {
+      i = (i + 1) & (keys.size() - 1);
+    }
+    return i;
+  }
+
+  std::vector<uint64_t> keys;
+  std::vector<unsigned long> values;
+  std::size_t count{0};
+  int shift{64};
+};
+
+// upper bound of the addresses written by a batch, 2^X per write in part 2. Capped to keep the
+// preallocation reasonable, the table grows past it
+template <typename Batch>
+std::size_t estimated_writes(const Batch& batch, bool floating) {
+  constexpr std::size_t cap = 1 << 24;
+  std::size_t writes = 0;
+  for_each_write(batch, [&](const FloatingMask& mask, uint64_t, unsigned long) {
+    std::size_t per_op = floating ? 1ull << Bitset(mask.floating).count() : 1;
+    writes = std::min(cap, writes + std::min(cap, per_op));
+  });
+  return writes;
+}
+
 struct Registry {
   void process(const std::vector<Operations>& ops_batch) {
+    memory.reserve(memory.size() + estimated_writes(ops_batch, false));
     for (const Operations& ops : ops_batch) {
       const auto& mask = ops.mask;
       for (const Operations::Op& op : ops.ops) {
-        this->map[op.address] = mask.apply(op.value);
+        memory[op.address] = mask.apply(op.value);
       };
     };
   }
 
   void process_part2(const std::vector<Operations>& ops_batch) {
+    memory.reserve(memory.size() + estimated_writes(ops_batch, true));
     for (const Operations& ops : ops_batch) {
       const auto& mask = ops.mask;
       for (const Operations::Op& op : ops.ops) {
         auto addresses = mask.addresses(op.address);
         // std::cout << addresses.size() << '\n';
         for (auto address : addresses) {
-          this->map[address] = op.value;
+          memory[address] = op.value;
         }
       }
     }
   }
 
-  unsigned long long sum() { return ranges::accumulate(map | ranges::view::values, 0ull); }
+  void process(const std::vector<DockingRecord>& records) {
+    memory.reserve(memory.size() + estimated_writes(records, false));
+    for_each_write(records, [&](const FloatingMask& mask, uint64_t address, unsigned long value) {
+      memory[address] = mask.apply(value);
+    });
+  }
+
+  void process_part2(const std::vector<DockingRecord>& records) { process_part2_floating(records); }
+
+  template <typename Batch>
+  void process_part2_floating(const Batch& batch) {
+    memory.reserve(memory.size() + estimated_writes(batch, true));
+    for_each_write(batch, [&](const FloatingMask& mask, uint64_t address, unsigned long value) {
+      mask.for_each_address(address, [&](uint64_t floating) { memory[floating] = value; });
+    });
+  }
+
+  // last writer wins: walking the batch backwards, only the first write seen per address is
+  // applied, memory itself tells which addresses are already written so it must start empty.
+  // Returns the number of writes skipped. Every write still costs one probe, only the stores of
+  // the skipped ones are saved: on the real input 5k of 73k part 2 writes are skipped and both
+  // directions run in the same time, it only pays off for programs that mostly overwrite
+  template <typename Batch>
+  std::size_t process_reverse(const Batch& batch) {
+    expect_empty();
+    memory.reserve(estimated_writes(batch, false));
+    std::size_t eliminated = 0;
+    for_each_write_backwards(
+        batch, [&](const FloatingMask& mask, uint64_t address, unsigned long value) {
+          eliminated += !memory.insert(address, mask.apply(value));
+        });
+    return eliminated;
+  }
+
+  template <typename Batch>
+  std::size_t process_part2_reverse(const Batch& batch) {
+    expect_empty();
+    memory.reserve(estimated_writes(batch, true));
+    std::size_t eliminated = 0;
+    for_each_write_backwards(
+        batch, [&](const FloatingMask& mask, uint64_t address, unsigned long value) {
+          mask.for_each_address(
+              address, [&](uint64_t floating) { eliminated += !memory.insert(floating, value); });
+        });
+    return eliminated;
+  }
+
+  void expect_empty() const {
+    if (memory.size() != 0) {
+      throw std::runtime_error("reverse processing needs an empty memory");
+    }
+  }
+
+  unsigned long long sum() { return memory.sum(); }
 
-  std::map<int, unsigned long> map;
+  MemoryTable memory;
 };
 
+// one shard per thread: every thread enumerates the whole batch in program order but only writes
+// the addresses of its shard, so last writer wins without locks. A mix independent from the table
+// hash keeps the keys of a shard spread over its table
+template <typename Batch>
+unsigned long long sum_part2_sharded(const Batch& batch,
+                                     int threads = std::thread::hardware_concurrency()) {
+  threads = std::max(1, threads);
+  const auto writes = estimated_writes(batch, true);
+  std::vector<unsigned long long> sums(threads);
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; t++) {
+    pool.emplace_back([&, t] {
+      const uint64_t shards = threads, mine = t;
+      MemoryTable shard;
+      shard.reserve(writes / shards);
+      for_each_write(batch, [&](const FloatingMask& mask, uint64_t address, unsigned long value) {
+        mask.for_each_address(address, [&](uint64_t floating) {
+          if (((floating ^ (floating >> 29)) * 0xBF58476D1CE4E5B9ull >> 32) % shards == mine) {
+            shard[floating] = value;
+          }
+        });
+      });
+      sums[t] = shard.sum();
+    });
+  }
+  for (auto& thread : pool) {
+    thread.join();
+  }
+  return ranges::accumulate(sums, 0ull);
+}
+
+// addresses with (address & care) == bits, the floating bits are the ones out of care
+struct AddressCube {
+  bool intersects(const AddressCube& other) const {
+    return (care & other.care & (bits ^ other.bits)) == 0;
+  }
+
+  uint64_t size() const { return 1ull << (36 - Bitset(care).count()); }
+
+  uint64_t bits;
+  uint64_t care;
+};
+
+// a minus b as disjoint cubes: a is split on every bit b cares about and a does not
+void subtract_cube(AddressCube a, const AddressCube& b, std::vector<AddressCube>& out) {
+  if (!a.intersects(b)) {
+    out.push_back(a);
+    return;
+  }
+  for (uint64_t split = b.care & ~a.care; split != 0; split &= split - 1) {
+    const uint64_t bit = split & -split;
+    out.push_back({(a.bits & ~bit) | (~b.bits & bit), a.care | bit});
+    a = {(a.bits & ~bit) | (b.bits & bit), a.care | bit};
+  }
+}
+
+// part 2 sum without expanding the floating addresses: walking the writes backwards, a write only
+// counts for the part of its cube that no later write covers. A 36 bit value times up to 2^36
+// addresses needs 72 bits, the sum is kept in 128 bits and throws if it does not fit the result
+template <typename Batch>
+unsigned long long sum_part2_symbolic(const Batch& batch) {
+  std::vector<AddressCube> covered;
+  std::vector<AddressCube> pieces, remaining;
+  unsigned __int128 sum = 0;
+  for_each_write_backwards(
+      batch, [&](const FloatingMask& mask, uint64_t address, unsigned long value) {
+        const uint64_t care = ~mask.floating & ((1ull << 36) - 1);
+        const AddressCube cube{(address | mask.ones) & care, care};
+        pieces.assign(1, cube);
+        for (const auto& later : covered) {
+          if (!cube.intersects(later)) {
+            continue;
+          }
+          remaining.clear();
+          for (const auto& piece : pieces) {
+            subtract_cube(piece, later, remaining);
+          }
+          std::swap(pieces, remaining);
+          if (pieces.empty()) {
+            break;
+          }
+        }
+        for (const auto& piece : pieces) {
+          sum += static_cast<unsigned __int128>(value) * piece.size();
+        }
+        covered.push_back(cube);
+      });
+  if (sum > std::numeric_limits<unsigned long long>::max()) {
+    throw std::overflow_error("part 2 sum does not fit 64 bits");
+  }
+  return static_cast<unsigned long long>(sum);
+}
+
 std::vector<Operations> read_operations(std::istream& in) {
   std::vector<Operations> ops;
 
@@ -155,7 +515,7 @@ std::vector<Operations> read_operations(std::istream& in) {
       }
       in.ignore(3);  // 'em['
 
-      int adress;
+      uint64_t adress;
       in >> adress;
 
       in.ignore(4);  // '] = '
@@ -169,6 +529,56 @@ std::vector<Operations> read_operations(std::istream& in) {
   return ops;
 }
 
+// one scan of the program text, masks are folded into their integer form on the way
+std::vector<DockingRecord> parse_docking_records(std::string_view text) {
+  std::vector<DockingRecord> records;
+  // addresses and values are 36 bit numbers of at least one digit
+  auto number = [&text](std::size_t& i) {
+    constexpr uint64_t limit = 1ull << 36;
+    const std::size_t first = i;
+    uint64_t n = 0;
+    for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; i++) {
+      n = n * 10 + (text[i] - '0');
+      if (n >= limit) {
+        throw std::runtime_error("number above 36 bits at "s + std::to_string(first));
+      }
+    }
+    if (i == first) {
+      throw std::runtime_error("missing number at "s + std::to_string(first));
+    }
+    return n;
+  };
+
+  for (std::size_t i = 0; i < text.size();) {
+    if (text[i] == ' ' || text[i] == '\n' || text[i] == '\r' || text[i] == '\t') {
+      i++;
+    } else if (text.compare(i, 7, "mask = ") == 0) {
+      i += 7;
+      uint64_t ones = 0, floating = 0;
+      std::size_t bits = 0;
+      for (; i < text.size() && (text[i] == '0' || text[i] == '1' || text[i] == 'X'); i++, bits++) {
+        ones = (ones << 1) | (text[i] == '1');
+        floating = (floating << 1) | (text[i] == 'X');
+      }
+      if (bits != 36) {
+        throw std::runtime_error("mask is not expected size"s + std::to_string(bits) + "!= 36"s);
+      }
+      records.push_back(DockingRecord::mask(ones, floating));
+    } else if (text.compare(i, 4, "mem[") == 0) {
+      i += 4;
+      auto address = number(i);
+      if (text.compare(i, 4, "] = ") != 0) {
+        throw std::runtime_error("unexpected write at "s + std::to_string(i));
+      }
+      i += 4;
+      records.push_back(DockingRecord::write(address, number(i)));
+    } else {
+      throw std::runtime_error("unexpected line at "s + std::to_string(i));
+    }
+  }
+  return records;
+}
+
 TEST_CASE("Day 14: Docking Data example"){
 
     SECTION("read input"){
@@ -191,9 +601,13 @@ REQUIRE(ops.front().ops.front().value == 11);
 
 Registry reg;
 reg.process(ops);
-REQUIRE(reg.map.size() == 2);
+REQUIRE(reg.memory.size() == 2);
 
 REQUIRE(reg.sum() == 165);
+
+Registry reverse;
+REQUIRE(reverse.process_reverse(ops) == 4);
+REQUIRE(reverse.memory == reg.memory);
 }
 SECTION("create mask from string") {
   Mask m{"XXXXXXXXXXXXXXXXXXXXXXXXXXXXX1XXXX0X"s};
@@ -218,6 +632,20 @@ TEST_CASE("day 14 part 1 ") {
 
   reg.process(ops_batch);
   std::cout << " day 14 part 1 : " << reg.sum() << "\n";
+
+  Registry reverse;
+  auto eliminated = reverse.process_reverse(ops_batch);
+  REQUIRE(reverse.memory == reg.memory);
+  REQUIRE(eliminated + reverse.memory.size() == estimated_writes(ops_batch, false));
+
+  std::ifstream text(DATA_DIR "/dataset/input_14.txt", std::ifstream::in);
+  auto records = parse_docking_records(std::string(std::istreambuf_iterator<char>(text), {}));
+  Registry from_records;
+  from_records.process(records);
+  REQUIRE(from_records.memory == reg.memory);
+  Registry reverse_records;
+  REQUIRE(reverse_records.process_reverse(records) == eliminated);
+  REQUIRE(reverse_records.memory == reg.memory);
 }
 
 TEST_CASE(" generate addresses") {
@@ -233,6 +661,52 @@ TEST_CASE(" generate addresses") {
 
   std::vector<unsigned long> aa = m.addresses(address);
   REQUIRE(aa == std::vector<unsigned long>{26, 58, 27, 59});
+
+  FloatingMask fm{m};
+  REQUIRE(fm.ones == 0b10010);
+  REQUIRE(fm.floating == 0b100001);
+  std::vector<uint64_t> floating;
+  fm.for_each_address(address, [&](uint64_t a) { floating.push_back(a); });
+  REQUIRE(floating == std::vector<uint64_t>{26, 27, 58, 59});
+
+  // 24 floating bits under 12 forced ones
+  FloatingMask all{Mask{std::string(12, '1') + std::string(24, 'X')}};
+  uint64_t count = 0;
+  uint64_t last = 0;
+  all.for_each_address(address, [&](uint64_t a) {
+    count++;
+    last = a;
+  });
+  REQUIRE(count == 1ull << 24);
+  REQUIRE(last == (1ull << 36) - 1);
+}
+
+TEST_CASE("Day 14: memory table") {
+  MemoryTable table;
+  table[1ull << 35] = 7;
+  table[(1ull << 35) + 1] = 5;
+  table[1] = 3;
+  REQUIRE(table.size() == 3);
+  REQUIRE(*table.find(1ull << 35) == 7);
+  REQUIRE(table.find(0) == nullptr);
+  REQUIRE(table.sum() == 15);
+
+  // grows past its reservation
+  for (uint64_t address = 0; address < 1000; address++) {
+    table[(address << 20) + 2] += 1;
+  }
+  REQUIRE(table.size() == 1003);
+  REQUIRE(*table.find(1) == 3);
+  REQUIRE(*table.find(2) == 1);
+  REQUIRE(table.sum() == 1015);
+
+  // addresses above 32 bits are not truncated
+  std::istringstream in(R"__(mask = 1X0000000000000000000000000000000000
+mem[0] = 5)__");
+  Registry reg;
+  reg.process_part2(read_operations(in));
+  REQUIRE(reg.memory.size() == 2);
+  REQUIRE(reg.sum() == 10);
 }
 
 TEST_CASE(" day 14 part2 example ") {
@@ -246,6 +720,104 @@ mem[26] = 1)__");
 
   reg.process_part2(ops);
   REQUIRE(reg.sum() == 208);
+
+  Registry floating;
+  floating.process_part2_floating(ops);
+  REQUIRE(floating.memory == reg.memory);
+
+  REQUIRE(sum_part2_symbolic(ops) == 208);
+
+  Registry reverse;
+  REQUIRE(reverse.process_part2_reverse(ops) == 2);
+  REQUIRE(reverse.memory == reg.memory);
+  REQUIRE_THROWS(reverse.process_part2_reverse(ops));
+
+  for (int threads = 1; threads <= 5; threads++) {
+    REQUIRE(sum_part2_sharded(ops, threads) == 208);
+  }
+}
+
+TEST_CASE("Day 14: docking records") {
+  std::string data(R"__(mask = 000000000000000000000000000000X1001X
+mem[42] = 100
+mask = 00000000000000000000000000000000X0XX
+mem[26] = 1
+)__");
+  std::istringstream in(data);
+  auto ops = read_operations(in);
+  auto records = parse_docking_records(data);
+
+  REQUIRE(records.size() == 4);
+  REQUIRE(records[0].is_mask());
+  REQUIRE(records[0].floating_mask().ones == 0b10010);
+  REQUIRE(records[0].floating_mask().floating == 0b100001);
+  REQUIRE_FALSE(records[1].is_mask());
+  REQUIRE(records[1].address() == 42);
+  REQUIRE(records[1].value() == 100);
+
+  Registry reg;
+  reg.process_part2(ops);
+
+  Registry from_records;
+  from_records.process_part2(records);
+  REQUIRE(from_records.memory == reg.memory);
+
+  Registry reverse;
+  REQUIRE(reverse.process_part2_reverse(records) == 2);
+  REQUIRE(reverse.memory == reg.memory);
+  REQUIRE(sum_part2_symbolic(records) == 208);
+  REQUIRE(sum_part2_sharded(records, 3) == 208);
+
+  REQUIRE_THROWS(parse_docking_records("mask = 0X1\n"));
+  REQUIRE_THROWS(parse_docking_records("mem[3] 4\n"));
+  REQUIRE_THROWS(parse_docking_records("mem[] = 5\n"));
+  REQUIRE_THROWS(parse_docking_records("mem[3] = \n"));
+  REQUIRE_THROWS(parse_docking_records("mem[3] = "));
+  REQUIRE_THROWS(parse_docking_records("mem[9223372036854775812] = 5\n"));
+  REQUIRE_THROWS(parse_docking_records("mem[68719476736] = 5\n"));
+  REQUIRE_THROWS(parse_docking_records("mem[3] = 68719476736\n"));
+  REQUIRE_THROWS(parse_docking_records("mem[3] = 5x\n"));
+  REQUIRE_THROWS(parse_docking_records("mem[3] = 5\n\xa0"));
+  REQUIRE_THROWS(parse_docking_records("mem[\xb2] = 5\n"));
+  auto widest = parse_docking_records("mem[68719476735] = 68719476735\n");
+  REQUIRE(widest.size() == 1);
+  REQUIRE_FALSE(widest[0].is_mask());
+  REQUIRE(widest[0].address() == (1ull << 36) - 1);
+  REQUIRE(widest[0].value() == (1ull << 36) - 1);
+}
+
+TEST_CASE("Day 14: symbolic floating addresses") {
+  SECTION("cube subtraction") {
+    // 1X0X minus X1X1 leaves 1X00 and 1001, 1101 is covered
+    AddressCube a{0b1000, 0b1010};
+    AddressCube b{0b0101, 0b0101};
+    std::vector<AddressCube> out;
+    subtract_cube(a, b, out);
+    uint64_t size = 0;
+    for (const auto& cube : out) {
+      REQUIRE_FALSE(cube.intersects(b));
+      size += cube.size();
+    }
+    REQUIRE(size == a.size() - (1ull << 32));
+
+    out.clear();
+    subtract_cube(b, AddressCube{0, 0}, out);
+    REQUIRE(out.empty());
+  }
+
+  SECTION("masks too wide to expand") {
+    std::istringstream in("mask = "s + std::string(36, 'X') + "\nmem[0] = 2\n"s + "mask = 1"s +
+                          std::string(35, 'X') + "\nmem[0] = 1\nmem[5] = 3"s);
+    auto ops = read_operations(in);
+    REQUIRE(sum_part2_symbolic(ops) == 2 * (1ull << 35) + 3 * (1ull << 35));
+  }
+
+  SECTION("sum above 64 bits") {
+    // (2^36 - 1) * 2^30 wrapped to 18446744072635809792 in 64 bits
+    std::istringstream in("mask = 000000"s + std::string(30, 'X') + "\nmem[0] = 68719476735"s);
+    auto ops = read_operations(in);
+    REQUIRE_THROWS_AS(sum_part2_symbolic(ops), std::overflow_error);
+  }
 }
 
 TEST_CASE("day 14 part2 ") {
@@ -258,4 +830,59 @@ TEST_CASE("day 14 part2 ") {
   reg.process_part2(ops);
 
   std::cout << " day 14 part 2 : " << reg.sum() << "\n";
-}
\ No newline at end of file
+
+  Registry floating;
+  floating.process_part2_floating(ops);
+  REQUIRE(floating.memory == reg.memory);
+
+  REQUIRE(sum_part2_symbolic(ops) == reg.sum());
+
+  Registry reverse;
+  auto eliminated = reverse.process_part2_reverse(ops);
+  REQUIRE(reverse.memory == reg.memory);
+  REQUIRE(eliminated + reverse.memory.size() == estimated_writes(ops, true));
+
+  REQUIRE(sum_part2_sharded(ops, 4) == reg.sum());
+
+  std::ifstream text(DATA_DIR "/dataset/input_14.txt", std::ifstream::in);
+  auto records = parse_docking_records(std::string(std::istreambuf_iterator<char>(text), {}));
+  Registry from_records;
+  from_records.process_part2(records);
+  REQUIRE(from_records.memory == reg.memory);
+  REQUIRE(sum_part2_symbolic(records) == reg.sum());
+}
+
+TEST_CASE("day 14 benchmark", "[.][benchmark][dataset]") {
+  std::ifstream in(DATA_DIR "/dataset/input_14.txt", std::ifstream::in);
+  const std::string text(std::istreambuf_iterator<char>(in), {});
+  std::istringstream parsed(text);
+  auto ops = read_operations(parsed);
+  auto records = parse_docking_records(text);
+
+  BENCHMARK("day 14 parse") {
+    std::istringstream input(text);
+    return read_operations(input);
+  };
+  BENCHMARK("day 14 parse records") { return parse_docking_records(text); };
+  BENCHMARK("day 14 part 1") {
+    Registry reg;
+    reg.process(ops);
+    return reg.sum();
+  };
+  BENCHMARK("day 14 part 2") {
+    Registry reg;
+    reg.process_part2(ops);
+    return reg.sum();
+  };
+  BENCHMARK("day 14 part 2 reverse") {
+    Registry reg;
+    reg.process_part2_reverse(records);
+    return reg.sum();
+  };
+  BENCHMARK("day 14 part 2 records") {
+    Registry reg;
+    reg.process_part2(records);
+    return reg.sum();
+  };
+  BENCHMARK("day 14 part 2 symbolic") { return sum_part2_symbolic(records); };
+}